@@ -1,7 +1,9 @@
 #ifndef VAST_ACTOR_ACTOR_H
 #define VAST_ACTOR_ACTOR_H
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #include <ostream>
 
 #include <caf/event_based_actor.hpp>
@@ -162,6 +164,16 @@ inline Stream& operator<<(Stream& out, default_actor const* a) {
 /// with `overloaded(false)`. Calls to these functions propagate the signal
 /// upstream to the sender. At the source producing data, the handlers for
 /// overload/underload should regulate the sender rate.
+///
+/// Instead of toggling its upstream nodes on and off, a downstream node may
+/// also grant them credit with a `<credit_atom, uint64_t, uint64_t>` message,
+/// which specifies a number of events and bytes of input. Once an actor has
+/// received credit, it ships events only as long as it has credit left, and
+/// consumes credit for every batch it ships. It ships batches as
+/// `<std::vector<event>, uint64_t>` messages carrying the number of input
+/// bytes consumed for the batch, so that the downstream node can account for
+/// the same credit without walking the events. The downstream node
+/// replenishes the credit as it processes batches.
 class flow_controlled_actor : public default_actor {
 public:
   flow_controlled_actor(char const* name = "flow-controlled-actor")
@@ -239,8 +251,46 @@ protected:
     return upstream_;
   }
 
+  /// Adds credit granted by a downstream node.
+  /// @param events The number of events granted.
+  /// @param bytes The number of input bytes granted.
+  void add_credit(uint64_t events, uint64_t bytes) {
+    VAST_DEBUG(this, "got credit for", events, "events and", bytes, "bytes");
+    credit_based_ = true;
+    credit_events_ += events;
+    credit_bytes_ += bytes;
+  }
+
+  /// Consumes credit for a shipped batch.
+  /// @param events The number of events in the batch.
+  /// @param bytes The number of input bytes consumed for the batch.
+  void consume_credit(uint64_t events, uint64_t bytes) {
+    credit_events_ -= std::min(events, credit_events_);
+    credit_bytes_ -= std::min(bytes, credit_bytes_);
+  }
+
+  /// Checks whether a downstream node has granted credit, in which case the
+  /// actor must ship only against available credit.
+  bool credit_based() const {
+    return credit_based_;
+  }
+
+  /// Checks whether the actor may ship another batch.
+  bool has_credit() const {
+    return !credit_based_ || (credit_events_ > 0 && credit_bytes_ > 0);
+  }
+
+  /// Retrieves the maximum number of events the actor may ship.
+  uint64_t available_credit() const {
+    return credit_based_ ? credit_events_
+                         : std::numeric_limits<uint64_t>::max();
+  }
+
 private:
   bool overloaded_ = false;
+  bool credit_based_ = false;
+  uint64_t credit_events_ = 0;
+  uint64_t credit_bytes_ = 0;
   util::flat_set<caf::actor> upstream_;
 };
 
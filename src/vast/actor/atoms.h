@@ -21,6 +21,7 @@ using announce_atom = caf::atom_constant<caf::atom("announce")>;
 using batch_atom = caf::atom_constant<caf::atom("batch")>;
 using connect_atom = caf::atom_constant<caf::atom("connect")>;
 using continuous_atom = caf::atom_constant<caf::atom("continuous")>;
+using credit_atom = caf::atom_constant<caf::atom("credit")>;
 using data_atom = caf::atom_constant<caf::atom("data")>;
 using disable_atom = caf::atom_constant<caf::atom("disable")>;
 using disconnect_atom = caf::atom_constant<caf::atom("disconnect")>;
@@ -178,7 +178,8 @@ exporter::exporter(expression ast, query_options opts)
       mask &= unprocessed_;
       VAST_ASSERT(mask.count() > 0);
       // Go through the current chunk and perform a candidate check for each
-      // hit, relaying event to the sink on success.
+      // hit, relaying the results to the sinks in one batch.
+      std::vector<event> results;
       auto extracted = uint64_t{0};
       auto last = event_id{0};
       for (auto id : mask) {
@@ -197,9 +198,7 @@ exporter::exporter(expression ast, query_options opts)
             VAST_DEBUG(this, "resolved AST for type", e->type() << ':', ast);
           }
           if (visit(expr::event_evaluator{*e}, ast)) {
-            auto msg = make_message(id_, std::move(*e));
-            for (auto& s : sinks_)
-              send(s, msg);
+            results.push_back(std::move(*e));
             ++total_results_;
             if (++extracted == pending_)
               break;
@@ -215,6 +214,11 @@ exporter::exporter(expression ast, query_options opts)
           return;
         }
       }
+      if (!results.empty()) {
+        auto msg = make_message(id_, std::move(results));
+        for (auto& s : sinks_)
+          send(s, msg);
+      }
       pending_ -= extracted;
       bitstream_type partial{last + 1, true};
       partial &= mask;
@@ -1,8 +1,14 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <fstream>
 
 #include <caf/all.hpp>
 
+#include "vast/config.h"
 #include "vast/key.h"
 #include "vast/actor/atoms.h"
 #include "vast/actor/identifier.h"
@@ -15,6 +21,34 @@ using namespace caf;
 namespace vast {
 namespace identifier {
 
+namespace {
+
+// The lease record holds two little-endian 64-bit integers.
+constexpr size_t lease_size = 16;
+
+void encode(event_id x, uint8_t* out) {
+  for (auto i = 0; i < 8; ++i)
+    out[i] = static_cast<uint8_t>(x >> (8 * i));
+}
+
+event_id decode(uint8_t const* in) {
+  event_id x = 0;
+  for (auto i = 0; i < 8; ++i)
+    x |= event_id{in[i]} << (8 * i);
+  return x;
+}
+
+// Writes the data of a file through to the storage device.
+bool sync(int fd) {
+#ifdef VAST_LINUX
+  return ::fdatasync(fd) == 0;
+#else
+  return ::fsync(fd) == 0;
+#endif
+}
+
+} // namespace <anonymous>
+
 state::state(event_based_actor* self)
   : basic_state{self, "identifier"}
 {
@@ -25,51 +59,166 @@ state::~state() {
     VAST_ERROR_AT(self, "failed to save local ID state");
     VAST_ERROR_AT(self, "has", id, "as current ID,", available, "available");
   }
+  if (lease != -1)
+    ::close(lease);
 }
 
 bool state::flush() {
   if (id == 0)
     return true;
-  if (!exists(dir) && !mkdir(dir))
-    return false;
-  std::ofstream avail{to_string(dir / "available")};
-  if (!avail)
-    return false;
-  avail << available << std::endl;
-  std::ofstream next{to_string(dir / "next")};
-  if (!next)
+  if (lease == -1) {
+    if (!exists(dir) && !mkdir(dir))
+      return false;
+    auto filename = dir / "lease";
+    lease = ::open(filename.str().data(), O_CREAT | O_WRONLY, 0644);
+    if (lease == -1) {
+      VAST_ERROR_AT(self, "failed to open ID lease:", filename,
+                    '(' << std::strerror(errno) << ')');
+      return false;
+    }
+    // Make the directory entry of a new lease durable as well.
+    auto d = ::open(dir.str().data(), O_RDONLY);
+    if (d != -1) {
+      ::fsync(d);
+      ::close(d);
+    }
+  }
+  // Overwrite the record in place with a single write, and wait until it
+  // reaches the storage device, such that a power loss cannot roll it back.
+  uint8_t record[lease_size];
+  encode(id, record);
+  encode(id + available, record + 8);
+  auto n = static_cast<ssize_t>(sizeof(record));
+  if (::pwrite(lease, record, sizeof(record), 0) != n || !sync(lease)) {
+    VAST_ERROR_AT(self, "failed to write ID lease:", std::strerror(errno));
     return false;
-  next << id << std::endl;
+  }
   return true;
 }
 
-behavior actor(experimental::stateful_actor<state>* self,
-               caf::actor store, path dir, event_id batch_size) {
-  self->state.store = std::move(store);
-  self->state.dir = std::move(dir);
-  self->state.batch_size = batch_size;
-  if (exists(self->state.dir)) {
-    // Load current batch size.
-    std::ifstream available{to_string(self->state.dir / "available")};
+namespace {
+
+// Loads the lease record, or the two text files of earlier versions.
+bool load(stateful_actor<state>* self) {
+  auto& dir = self->state.dir;
+  if (exists(dir / "lease")) {
+    std::ifstream lease{to_string(dir / "lease"), std::ios::binary};
+    uint8_t record[lease_size];
+    if (!lease.read(reinterpret_cast<char*>(record), sizeof(record))) {
+      VAST_ERROR_AT(self, "failed to read ID lease:", dir / "lease");
+      return false;
+    }
+    self->state.id = decode(record);
+    self->state.available = decode(record + 8) - self->state.id;
+  } else {
+    std::ifstream available{to_string(dir / "available")};
     if (!available) {
-      VAST_ERROR_AT(self, "failed to open ID batch file:",
-                    self->state.dir / "available",
+      VAST_ERROR_AT(self, "failed to open ID batch file:", dir / "available",
                     '(' << std::strerror(errno) << ')');
-      self->quit(exit::error);
-      return {};
+      return false;
     }
     available >> self->state.available;
-    VAST_INFO_AT(self, "found", self->state.available, "local IDs");
-    // Load next ID.
-    std::ifstream next{to_string(self->state.dir / "next")};
+    std::ifstream next{to_string(dir / "next")};
     if (!next) {
-      VAST_ERROR_AT(self, "failed to open ID file:", self->state.dir / "next",
+      VAST_ERROR_AT(self, "failed to open ID file:", dir / "next",
                     '(' << std::strerror(errno) << ')');
-      self->quit(exit::error);
-      return {};
+      return false;
     }
     next >> self->state.id;
-    VAST_INFO_AT(self, "found next event ID:", self->state.id);
+  }
+  VAST_INFO_AT(self, "found", self->state.available, "local IDs");
+  VAST_INFO_AT(self, "found next event ID:", self->state.id);
+  return true;
+}
+
+// Hands out up to n IDs, but at most as many as we have locally.
+void hand_out(stateful_actor<state>* self, response_promise& rp,
+              event_id n) {
+  VAST_ASSERT(self->state.available > 0);
+  n = std::min(n, self->state.available);
+  VAST_DEBUG_AT(self, "hands out [" << self->state.id << ',' <<
+                self->state.id + n << "),", self->state.available - n,
+                "local IDs remaining");
+  auto first = self->state.id;
+  self->state.id += n;
+  self->state.available -= n;
+  // Record the lease before the requester can use it.
+  if (!self->state.flush()) {
+    VAST_ERROR_AT(self, "failed to save local ID state");
+    rp.deliver(make_message(error{"failed to save local ID state"}));
+    self->quit(exit::error);
+    return;
+  }
+  rp.deliver(make_message(id_atom::value, first, first + n));
+}
+
+void replenish(stateful_actor<state>* self) {
+  if (self->state.replenishing)
+    return;
+  // Avoid too frequent replenishing.
+  if (time::snapshot() - self->state.last_replenish < time::seconds(10)) {
+    VAST_VERBOSE_AT(self, "had to replenish twice within 10 secs");
+    VAST_VERBOSE_AT(self, "doubles batch size:", self->state.batch_size,
+                    "->", self->state.batch_size * 2);
+    self->state.batch_size *= 2;
+  }
+  // Make sure that a single round satisfies all waiting requesters.
+  auto demand = event_id{0};
+  for (auto& w : self->state.waiting)
+    demand += w.second;
+  while (self->state.batch_size < demand)
+    self->state.batch_size *= 2;
+  self->state.last_replenish = time::snapshot();
+  self->state.replenishing = true;
+  VAST_DEBUG_AT(self, "replenishes local IDs:", self->state.available,
+                "available,", self->state.batch_size, "requested");
+  VAST_ASSERT(max_event_id - self->state.id >= self->state.batch_size);
+  self->sync_send(self->state.store, add_atom::value, key::str("id"),
+            self->state.batch_size).then(
+    [=](event_id old, event_id now) {
+      self->state.replenishing = false;
+      self->state.id = old;
+      self->state.available = now - old;
+      VAST_VERBOSE_AT(self, "got", self->state.available,
+                      "new IDs starting at", old);
+      if (!self->state.flush()) {
+        self->quit(exit::error);
+        VAST_ERROR_AT(self, "failed to save local ID state");
+        return;
+      }
+      // Serve the waiting requesters in order as long as we have IDs, and
+      // let the remaining ones wait for the next round.
+      auto waiting = std::move(self->state.waiting);
+      self->state.waiting.clear();
+      auto w = waiting.begin();
+      for ( ; w != waiting.end() && self->state.available > 0; ++w)
+        hand_out(self, w->first, w->second);
+      waiting.erase(waiting.begin(), w);
+      if (!waiting.empty()) {
+        self->state.waiting = std::move(waiting);
+        replenish(self);
+      }
+    },
+    [=](error const& e) {
+      VAST_ERROR_AT(self, "got error:", e);
+      VAST_ERROR_AT(self, "failed to obtain", self->state.batch_size,
+                    "new IDs");
+      self->quit(exit::error);
+    },
+    quit_on_others(self)
+  );
+}
+
+} // namespace <anonymous>
+
+behavior actor(experimental::stateful_actor<state>* self,
+               caf::actor store, path dir, event_id batch_size) {
+  self->state.store = std::move(store);
+  self->state.dir = std::move(dir);
+  self->state.batch_size = batch_size;
+  if (exists(self->state.dir) && !load(self)) {
+    self->quit(exit::error);
+    return {};
   }
   return {
     [=](id_atom) {
@@ -81,6 +230,13 @@ behavior actor(experimental::stateful_actor<state>* self,
         rp.deliver(make_message(error{"cannot hand out 0 ids"}));
         return;
       }
+      // Rather than handing out an empty range, we let the requester wait
+      // until we have new IDs.
+      if (self->state.available == 0 || !self->state.waiting.empty()) {
+        self->state.waiting.emplace_back(std::move(rp), n);
+        replenish(self);
+        return;
+      }
       // If the requester wants more than we can locally offer, we give
       // everything we have, but double the batch size to avoid future
       // shortage.
@@ -89,50 +245,13 @@ behavior actor(experimental::stateful_actor<state>* self,
                         self->state.available);
         VAST_VERBOSE_AT(self, "doubles batch size:", self->state.batch_size,
                         "->", self->state.batch_size * 2);
-        n = self->state.available;
         self->state.batch_size *= 2;
       }
-      VAST_DEBUG_AT(self, "hands out [" << self->state.id << ',' <<
-                    self->state.id + n << "),", self->state.available - n,
-                    "local IDs remaining");
-      rp.deliver(make_message(id_atom::value, self->state.id,
-                              self->state.id + n));
-      self->state.id += n;
-      self->state.available -= n;
+      hand_out(self, rp, n);
       // Replenish if we're running low of IDs (or are already out of 'em).
-      if (self->state.available == 0 
-          || self->state.available < self->state.batch_size * 0.1) {
-        // Avoid too frequent replenishing.
-        if (time::snapshot() - self->state.last_replenish < time::seconds(10)) {
-          VAST_VERBOSE_AT(self, "had to replenish twice within 10 secs");
-          VAST_VERBOSE_AT(self, "doubles batch size:", self->state.batch_size,
-                          "->", self->state.batch_size * 2);
-          self->state.batch_size *= 2;
-        }
-        self->state.last_replenish = time::snapshot();
-        VAST_DEBUG_AT(self, "replenishes local IDs:", self->state.available,
-                      "available,", self->state.batch_size, "requested");
-        VAST_ASSERT(max_event_id - self->state.id >= self->state.batch_size);
-        self->sync_send(self->state.store, add_atom::value, key::str("id"),
-                  self->state.batch_size).then(
-          [=](event_id old, event_id now) {
-            self->state.id = old;
-            self->state.available = now - old;
-            VAST_VERBOSE_AT(self, "got", self->state.available,
-                            "new IDs starting at", old);
-            if (!self->state.flush()) {
-              self->quit(exit::error);
-              VAST_ERROR_AT(self, "failed to save local ID state");
-            }
-          },
-          [=](error const& e) {
-            VAST_ERROR_AT(self, "got error:", e);
-            VAST_ERROR_AT(self, "failed to obtain", n, "new IDs:");
-            self->quit(exit::error);
-          },
-          quit_on_others(self)
-        );
-      }
+      if (self->state.available == 0
+          || self->state.available < self->state.batch_size * 0.1)
+        replenish(self);
     },
     quit_on_others(self)
   };
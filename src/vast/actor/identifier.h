@@ -1,6 +1,11 @@
 #ifndef VAST_ACTOR_IDENTIFIER_H
 #define VAST_ACTOR_IDENTIFIER_H
 
+#include <utility>
+#include <vector>
+
+#include <caf/response_promise.hpp>
+
 #include "vast/aliases.h"
 #include "vast/time.h"
 #include "vast/filesystem.h"
@@ -13,17 +18,25 @@ struct state : basic_state {
   state(event_based_actor* self);
   ~state();
 
+  /// Writes the lease record, which consists of the next ID to hand out and
+  /// the end of the locally available range, through to disk.
   bool flush();
 
   actor store;
   path dir;
+  int lease = -1;
   event_id id = 0;
   event_id available = 0;
   event_id batch_size = 1;
   time::moment last_replenish = time::snapshot();
+  bool replenishing = false;
+  std::vector<std::pair<caf::response_promise, event_id>> waiting;
 };
 
-/// Spawns the ID tracker.
+/// Spawns the ID tracker. The tracker hands out ranges of IDs to importers,
+/// which then assign them to events locally. Before handing out a range, the
+/// tracker records the next available ID in a fixed-size lease record, so
+/// that it never hands out an ID twice, even after a crash.
 /// @param self The actor handle.
 /// @param store The key-value store to ask for more IDs.
 /// @param dir The directory where to save local state to.
@@ -1,20 +1,26 @@
+#include <algorithm>
+
 #include <caf/all.hpp>
 
 #include "vast/event.h"
 #include "vast/actor/importer.h"
 #include "vast/concept/printable/vast/error.h"
+#include "vast/util/math.h"
 
 namespace vast {
 
 using namespace caf;
 
-importer::importer() : flow_controlled_actor{"importer"} {
+importer::importer(event_id lease_size)
+  : flow_controlled_actor{"importer"},
+    lease_size_{std::max(lease_size, event_id{1})} {
 }
 
 void importer::on_exit() {
   identifier_ = invalid_actor;
   archive_ = invalid_actor;
   index_ = invalid_actor;
+  pending_.clear();
 }
 
 behavior importer::make_behavior() {
@@ -42,14 +48,46 @@ behavior importer::make_behavior() {
     }
     return true;
   };
+  auto accept = [=](std::vector<event>& events) {
+    if (! dependencies_alive())
+      return;
+    if (events.empty())
+      return;
+    // Preserve the order of batches while waiting for a lease.
+    if (!pending_.empty() || available_ < events.size()) {
+      VAST_DEBUG(this, "waits for IDs: needs", events.size(), "has",
+                 available_);
+      pending_events_ += events.size();
+      pending_.push_back(std::move(events));
+    } else {
+      ship(std::move(events));
+    }
+    renew_lease();
+    grant_credit();
+  };
   return {
-    forward_overload(),
-    forward_underload(),
-    register_upstream_node(),
+    [=](overload_atom) {
+      overloaded_downstream_.insert(current_sender());
+    },
+    [=](underload_atom) {
+      overloaded_downstream_.erase(current_sender());
+      grant_credit();
+    },
+    [=](upstream_atom, actor const& upstream) {
+      add_upstream_node(upstream);
+      credit_.emplace(upstream, credit{});
+      grant_credit();
+    },
     exit_handler,
     [=](down_msg const& msg) {
-      if (remove_upstream_node(msg.source))
+      if (remove_upstream_node(msg.source)) {
+        auto i = std::find_if(credit_.begin(), credit_.end(),
+                              [&](auto& x) { return x.first == msg.source; });
+        if (i != credit_.end())
+          credit_.erase(i);
         return;
+      }
+      overloaded_downstream_.erase(msg.source);
       if (msg.source == identifier_)
         identifier_ = invalid_actor;
       else if (msg.source == archive_)
@@ -61,6 +99,7 @@ behavior importer::make_behavior() {
       VAST_DEBUG(this, "registers identifier", a);
       monitor(a);
       identifier_ = a;
+      renew_lease();
     },
     [=](put_atom, archive_atom, actor const& a) {
       VAST_DEBUG(this, "registers archive", a);
@@ -74,57 +113,149 @@ behavior importer::make_behavior() {
       monitor(a);
       index_ = a;
     },
+    [=](std::vector<event>& events, uint64_t bytes) {
+      // Upstream nodes with credit report the input size of their batches,
+      // which we deduct from the credit we have granted them.
+      auto i = std::find_if(credit_.begin(), credit_.end(),
+                            [&](auto& x) { return x.first == current_sender(); });
+      if (i != credit_.end()) {
+        auto& c = i->second;
+        c.events -= std::min<uint64_t>(events.size(), c.events);
+        c.bytes -= std::min(bytes, c.bytes);
+        if (!events.empty())
+          util::ewma(bytes_per_event_,
+                     static_cast<double>(bytes) / events.size());
+      }
+      accept(events);
+    },
     [=](std::vector<event>& events) {
-      if (! dependencies_alive())
+      accept(events);
+    },
+    [=](done_atom, uint64_t events) {
+      // INDEX reports every batch it has indexed completely.
+      measure(events);
+      grant_credit();
+    },
+    [=](id_atom, event_id from, event_id to)  {
+      VAST_ASSERT(!requests_.empty());
+      requested_ -= requests_.front();
+      requests_.pop_front();
+      VAST_DEBUG(this, "leased", to - from, "IDs [" << from << "," << to << ")");
+      if (from < to) {
+        leases_.emplace_back(from, to);
+        available_ += to - from;
+      }
+      if (! pending_.empty() && ! dependencies_alive())
         return;
-      event_id needed = events.size();
-      batch_ = std::move(events);
-      send(identifier_, request_atom::value, needed);
-      become(
-        keep_behavior,
-        [=](std::vector<event> const&) {
-          // Wait until we've processed the current batch.
-          return skip_message();
-        },
-        [=](id_atom, event_id from, event_id to)  {
-          auto n = to - from;
-          got_ += n;
-          VAST_DEBUG(this, "got", n, "IDs [" << from << "," << to << ")");
-          for (auto i = 0u; i < n; ++i)
-            batch_[i].id(from++);
-          if (got_ < needed) {
-            if (got_ > 0) {
-              // We take the front slice and ship it separately until
-              // IDENTIFIER has calibrated itself.
-              auto remainder = std::vector<event>(
-                std::make_move_iterator(batch_.begin() + n),
-                std::make_move_iterator(batch_.end()));
-              batch_.resize(n);
-              auto msg = make_message(std::move(batch_));
-              send(archive_, msg);
-              send(index_, msg);
-              batch_ = std::move(remainder);
-            }
-            VAST_VERBOSE(this, "asks for more IDs: got", got_,
-                         "so far, still need", needed - got_);
-            send(identifier_, request_atom::value, needed - got_);
-          } else {
-            // Ship the batch directly if we got enough IDs.
-            auto msg = make_message(std::move(batch_));
-            send(archive_, msg);
-            send(index_, msg);
-            got_ = 0;
-            unbecome();
-          }
-        },
-        [=](error const& e) {
-          VAST_ERROR(this, e);
-          quit(exit::error);
-        }
-      );
+      while (!pending_.empty() && pending_.front().size() <= available_) {
+        pending_events_ -= pending_.front().size();
+        ship(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+      renew_lease();
+      grant_credit();
+    },
+    [=](error const& e) {
+      VAST_ERROR(this, e);
+      quit(exit::error);
     },
     catch_unexpected()
   };
 }
 
+void importer::ship(std::vector<event> events) {
+  VAST_ASSERT(available_ >= events.size());
+  available_ -= events.size();
+  // Archive and index expect contiguous IDs per batch, so we split batches
+  // spanning multiple leases.
+  auto begin = events.begin();
+  while (begin != events.end()) {
+    auto& lease = leases_.front();
+    auto n = std::min<event_id>(lease.second - lease.first,
+                                events.end() - begin);
+    for (auto i = begin; i != begin + n; ++i)
+      i->id(lease.first++);
+    if (lease.first == lease.second)
+      leases_.pop_front();
+    if (begin == events.begin() && begin + n == events.end()) {
+      auto msg = make_message(std::move(events));
+      send(archive_, msg);
+      send(index_, msg);
+      return;
+    }
+    auto msg = make_message(std::vector<event>(
+      std::make_move_iterator(begin), std::make_move_iterator(begin + n)));
+    send(archive_, msg);
+    send(index_, msg);
+    begin += n;
+  }
+}
+
+void importer::renew_lease() {
+  if (identifier_ == invalid_actor)
+    return;
+  // We renew the lease when the available IDs drop below half a lease, and
+  // always request enough to satisfy the batches waiting for IDs.
+  while (requests_.size() < max_lease_requests) {
+    auto ids = available_ + requested_;
+    if (ids >= pending_events_ + lease_size_ / 2)
+      return;
+    auto n = std::max(lease_size_,
+                      pending_events_ - std::min(pending_events_, ids));
+    VAST_DEBUG(this, "renews lease:", available_, "IDs available,",
+               requested_, "requested,", pending_events_,
+               "pending, requesting", n);
+    requests_.push_back(n);
+    requested_ += n;
+    send(identifier_, request_atom::value, n);
+  }
+}
+
+bool importer::throttled() const {
+  return !overloaded_downstream_.empty()
+         || pending_.size() >= max_pending_batches;
+}
+
+void importer::grant_credit() {
+  if (credit_.empty() || throttled())
+    return;
+  auto clamp = [](double x, uint64_t min, uint64_t max) {
+    return std::min(std::max(static_cast<uint64_t>(x), min), max);
+  };
+  // The window covers the events which INDEX can process within one second,
+  // and the input those events occupy. Each upstream node gets an equal
+  // share.
+  auto events = clamp(events_per_second_, min_credit_events,
+                      max_credit_events) / credit_.size();
+  auto bytes = clamp(events_per_second_ * bytes_per_event_, min_credit_bytes,
+                     max_credit_bytes) / credit_.size();
+  for (auto& x : credit_) {
+    auto& c = x.second;
+    // Topping up only below half the share avoids a flood of small grants.
+    if (c.events > events / 2 && c.bytes > bytes / 2)
+      continue;
+    auto more_events = events - std::min(events, c.events);
+    auto more_bytes = bytes - std::min(bytes, c.bytes);
+    VAST_DEBUG(this, "grants", x.first, "credit for", more_events,
+               "events and", more_bytes, "bytes");
+    c.events += more_events;
+    c.bytes += more_bytes;
+    send(x.first, credit_atom::value, more_events, more_bytes);
+  }
+}
+
+void importer::measure(uint64_t events) {
+  completed_events_ += events;
+  auto now = time::snapshot();
+  auto elapsed = time::duration_cast<time::double_seconds>(
+    now - last_measurement_).count();
+  if (elapsed < 1)
+    return;
+  util::ewma(events_per_second_, completed_events_ / elapsed);
+  VAST_DEBUG(this, "measured an indexing rate of", events_per_second_,
+             "events/sec");
+  completed_events_ = 0;
+  last_measurement_ = now;
+}
+
 } // namespace vast
@@ -1,28 +1,97 @@
 #ifndef VAST_ACTOR_IMPORTER_H
 #define VAST_ACTOR_IMPORTER_H
 
+#include <deque>
+#include <map>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "vast/aliases.h"
 #include "vast/event.h"
+#include "vast/time.h"
 #include "vast/actor/actor.h"
+#include "vast/util/flat_set.h"
 
 namespace vast {
 
 /// Receives chunks from SOURCEs, imbues them with an ID, and relays them to
 /// ARCHIVE and INDEX.
+///
+/// The importer leases ranges of IDs from IDENTIFIER ahead of time and
+/// assigns them locally. It renews its lease in the background when running
+/// low, such that assigning IDs does not require a round-trip per batch.
+/// When the lease runs dry, incoming batches wait in a bounded window while
+/// up to two lease requests are underway. Batches leave the importer in the
+/// order they arrived.
+///
+/// The importer regulates its sources with credit. It keeps the credit of all
+/// sources at a window of events and bytes which it sizes from the rate at
+/// which INDEX completes batches. Measuring the incoming rate instead would
+/// only reflect the credit the importer granted. As a last resort, the
+/// importer stops replenishing credit while ARCHIVE or INDEX is overloaded or
+/// too many batches wait for IDs.
 struct importer : flow_controlled_actor {
-  importer();
+  /// Constructs an importer.
+  /// @param lease_size The number of IDs to lease from IDENTIFIER at once.
+  importer(event_id lease_size = 1 << 16);
 
   void on_exit() override;
   caf::behavior make_behavior() override;
 
+  // Assigns IDs to a batch and relays it to ARCHIVE and INDEX.
+  // @pre `available_ >= events.size()`
+  void ship(std::vector<event> events);
+
+  // Requests new leases until the available and requested IDs cover the
+  // pending batches plus half a lease.
+  void renew_lease();
+
+  // Checks whether the importer should withhold credit.
+  bool throttled() const;
+
+  // Replenishes the credit of upstream nodes whose credit fell below half
+  // their share of the window.
+  void grant_credit();
+
+  // Updates the service rate estimate with a batch completed by INDEX.
+  void measure(uint64_t events);
+
+  // The maximum number of lease requests underway at the same time.
+  static constexpr size_t max_lease_requests = 2;
+
+  // The number of batches waiting for IDs at which the importer stops
+  // granting credit.
+  static constexpr size_t max_pending_batches = 8;
+
+  // The bounds of the credit window, which covers one second of indexing at
+  // the measured rate.
+  static constexpr uint64_t min_credit_events = 1 << 16;
+  static constexpr uint64_t max_credit_events = 1 << 22;
+  static constexpr uint64_t min_credit_bytes = 64 << 20;
+  static constexpr uint64_t max_credit_bytes = uint64_t{1} << 30;
+
+  struct credit {
+    uint64_t events = 0;
+    uint64_t bytes = 0;
+  };
+
   caf::actor identifier_;
   caf::actor archive_;
   caf::actor index_;
-  event_id got_ = 0;
-  std::vector<event> batch_;
+  event_id lease_size_;
+  std::deque<std::pair<event_id, event_id>> leases_;
+  event_id available_ = 0;
+  std::deque<event_id> requests_;
+  event_id requested_ = 0;
+  std::deque<std::vector<event>> pending_;
+  event_id pending_events_ = 0;
+  std::map<caf::actor, credit> credit_;
+  util::flat_set<caf::actor_addr> overloaded_downstream_;
+  double events_per_second_ = 0;
+  double bytes_per_event_ = 0;
+  uint64_t completed_events_ = 0;
+  time::moment last_measurement_ = time::snapshot();
 };
 
 } // namespace vast
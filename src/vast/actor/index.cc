@@ -1,3 +1,5 @@
+#include <limits>
+
 #include <caf/all.hpp>
 
 #include "vast/bitmap_index.h"
@@ -6,6 +8,8 @@
 #include "vast/actor/index.h"
 #include "vast/actor/partition.h"
 #include "vast/actor/task.h"
+#include "vast/expr/evaluator.h"
+#include "vast/expr/resolver.h"
 #include "vast/expr/restrictor.h"
 #include "vast/concept/printable/to_string.h"
 #include "vast/concept/printable/vast/expression.h"
@@ -24,6 +28,82 @@ using namespace caf;
 
 namespace vast {
 
+namespace {
+
+// Evaluates continuous queries directly on event batches, i.e., without
+// waiting until the batches have been indexed.
+struct continuous_evaluator : default_actor {
+  continuous_evaluator(actor sink)
+    : default_actor{"continuous-evaluator"}, sink_{std::move(sink)} {
+  }
+
+  void on_exit() override {
+    sink_ = invalid_actor;
+    queries_.clear();
+  }
+
+  behavior make_behavior() override {
+    return {
+      [=](expression const& expr, continuous_atom) {
+        VAST_DEBUG(this, "adds query:", expr);
+        queries_[expr];
+      },
+      [=](expression const& expr, continuous_atom, disable_atom) {
+        VAST_DEBUG(this, "removes query:", expr);
+        queries_.erase(expr);
+      },
+      [=](std::vector<event> const& events) {
+        auto start = time::snapshot();
+        for (auto& q : queries_) {
+          index::bitstream_type hits;
+          type const* last = nullptr;
+          expression const* resolved = nullptr;
+          for (auto& e : events) {
+            // Batches typically contain long runs of the same type, so we only
+            // look up the resolved query when the type changes.
+            if (!last || e.type() != *last) {
+              last = &e.type();
+              auto i = q.second.find(*last);
+              if (i == q.second.end())
+                i = q.second.emplace(*last, resolve(q.first, *last)).first;
+              resolved = &i->second;
+            }
+            if (is<none>(*resolved) || e.id() < hits.size())
+              continue;
+            if (visit(expr::event_evaluator{e}, *resolved)) {
+              hits.append(e.id() - hits.size(), false);
+              hits.push_back(true);
+            }
+          }
+          if (!hits.empty()) {
+            VAST_DEBUG(this, "relays", hits.count(), "hits for", q.first);
+            send(sink_, q.first, std::move(hits), continuous_atom::value);
+          }
+        }
+        VAST_DEBUG(this, "evaluated", queries_.size(), "queries on",
+                   events.size(), "events in", time::snapshot() - start);
+      }
+    };
+  }
+
+  // Resolves a query for a given event type. Returns an empty expression if
+  // the query cannot match events of the type.
+  expression resolve(expression const& expr, type const& t) {
+    auto r = visit(expr::schema_resolver{t}, expr);
+    if (!r) {
+      VAST_WARN(this, "failed to resolve", expr, "for", t.name() << ':',
+                r.error());
+      return {};
+    }
+    return visit(expr::type_resolver{t}, *r);
+  }
+
+  actor sink_;
+  std::map<expression, std::unordered_map<type, expression>> queries_;
+};
+
+} // namespace <anonymous>
+
 template <typename Serializer>
 void serialize(Serializer& sink, index::partition_state const& ps) {
   sink << ps.events << ps.from << ps.to << ps.last_modified;
@@ -35,31 +115,56 @@ void deserialize(Deserializer& source, index::partition_state& ps) {
 }
 
 index::index(path const& dir, size_t max_events, size_t passive_parts,
-             size_t active_parts)
+             size_t active_parts, size_t query_parts, uint64_t passive_bytes)
   : flow_controlled_actor{"index"},
     dir_{dir},
-    max_events_per_partition_{max_events} {
+    max_events_per_partition_{max_events},
+    scheduler_{query_parts},
+    max_passive_bytes_{passive_bytes} {
   trap_exit(true);
   VAST_ASSERT(max_events_per_partition_ > 0);
   VAST_ASSERT(active_parts > 0);
-  VAST_ASSERT(passive_parts > 0);
   active_.resize(active_parts);
-  passive_.capacity(passive_parts);
+  // Without a count limit, only the memory budget bounds passive partitions.
+  passive_.capacity(passive_parts > 0 ? passive_parts
+                                      : std::numeric_limits<size_t>::max());
   passive_.on_evict([=](uuid id, actor& p) {
     VAST_DEBUG(this, "evicts partition", id);
     send_exit(p, exit::stop);
+    passive_bytes_ -= partitions_[id].bytes;
   });
 }
 
 void index::on_exit() {
   accountant_ = invalid_actor;
+  prefetcher_ = invalid_actor;
+  streamer_ = invalid_actor;
   queries_.clear();
 }
 
 behavior index::make_behavior() {
   VAST_VERBOSE(this, "caps partitions at", max_events_per_partition_, "events");
-  VAST_VERBOSE(this, "uses at most", passive_.capacity(), "passive partitions");
+  if (passive_.capacity() < std::numeric_limits<size_t>::max())
+    VAST_VERBOSE(this, "uses at most", passive_.capacity(),
+                 "passive partitions");
   VAST_VERBOSE(this, "uses", active_.size(), "active partitions");
+  VAST_VERBOSE(this, "loads at most", scheduler_.max_inflight(),
+               "partitions per query");
+  if (max_passive_bytes_ > 0)
+    VAST_VERBOSE(this, "uses at most", max_passive_bytes_ >> 20,
+                 "MB for passive partitions");
+  // Prefetching and measuring partitions block on the filesystem, so we keep
+  // them off the INDEX.
+  prefetcher_ = spawn<detached>([](event_based_actor* self) {
+    return behavior{
+      [=](uuid const& part, path const& p) {
+        VAST_DEBUG_AT(self, "prefetches", p);
+        prefetch(p);
+        self->send(actor_cast<actor>(self->current_sender()), part,
+                   disk_usage(p));
+      }
+    };
+  });
   // Load meta data about each partition.
   if (exists(dir_ / "meta")) {
     using vast::load;
@@ -93,11 +198,17 @@ behavior index::make_behavior() {
     register_upstream_node(),
     [=](exit_msg const& msg) {
       if (msg.reason == exit::kill) {
+        send_exit(prefetcher_, exit::kill);
+        if (streamer_)
+          send_exit(streamer_, exit::kill);
         quit(exit::kill);
         return;
       }
       if (downgrade_exit())
         return;
+      send_exit(prefetcher_, msg.reason);
+      if (streamer_)
+        send_exit(streamer_, msg.reason);
       flush();
       trap_exit(false); // Once the task completes we go down with it.
       auto t = spawn<task, linked>();
@@ -119,16 +230,24 @@ behavior index::make_behavior() {
     [=](down_msg const& msg) {
       if (remove_upstream_node(msg.source))
         return;
+      if (streamer_ && msg.source == streamer_) {
+        streamer_ = invalid_actor;
+        return;
+      }
       for (auto q = queries_.begin(); q != queries_.end(); ++q)
         if (q->second.subscribers.erase(actor_cast<actor>(msg.source)) == 1) {
           if (q->second.subscribers.empty()) {
             VAST_VERBOSE(this, "removes query subscriber", msg.source);
             if (q->second.cont) {
               VAST_VERBOSE(this, "disables continuous query:", q->first);
-              q->second.cont = {};
-              for (auto& a : active_)
-                send(a.second, q->first, continuous_atom::value,
+              if (q->second.cont->streaming)
+                send(streamer_, q->first, continuous_atom::value,
                      disable_atom::value);
+              else
+                for (auto& a : active_)
+                  send(a.second, q->first, continuous_atom::value,
+                       disable_atom::value);
+              q->second.cont = {};
             }
             if (!q->second.cont && !q->second.hist) {
               VAST_VERBOSE(this, "removes query:", q->first);
@@ -146,6 +265,7 @@ behavior index::make_behavior() {
       }
       for (auto i = passive_.begin(); i != passive_.end(); ++i) {
         if (i->second.address() == msg.source) {
+          passive_bytes_ -= partitions_[i->first].bytes;
           passive_.erase(i->first);
           VAST_DEBUG(this, "shrinks passive partitions to",
                      passive_.size() << '/' << passive_.capacity());
@@ -153,6 +273,18 @@ behavior index::make_behavior() {
         }
       }
     },
+    [=](uuid const& part, uint64_t bytes) {
+      auto& ps = partitions_[part];
+      if (ps.measured)
+        return;
+      VAST_DEBUG(this, "measured partition", part, "with", bytes >> 20, "MB");
+      ps.bytes = bytes;
+      ps.measured = true;
+      // A partition may have loaded before its size arrived.
+      if (passive_.contains(part))
+        passive_bytes_ += bytes;
+      schedule();
+    },
     [=](put_atom, accountant_atom, actor const& accountant) {
       VAST_DEBUG(this, "registers accountant", accountant);
       accountant_ = accountant;
@@ -169,6 +301,9 @@ behavior index::make_behavior() {
       return t;
     },
     [=](std::vector<event> const& events) {
+      // Streaming queries see the events before they get indexed.
+      if (streamer_)
+        send(streamer_, current_message());
       auto& a = active_[next_active_++ % active_.size()];
       auto i = partitions_.find(a.first);
       VAST_ASSERT(i != partitions_.end());
@@ -187,7 +322,7 @@ behavior index::make_behavior() {
         i = partitions_.emplace(a.first, partition_state()).first;
         // Register continuous queries.
         for (auto& q : queries_)
-          if (q.second.cont)
+          if (q.second.cont && !q.second.cont->streaming)
             send(a.second, q.first, continuous_atom::value);
       }
       // Update partition meta data.
@@ -202,7 +337,8 @@ behavior index::make_behavior() {
       VAST_DEBUG(this, "forwards", events.size(), "events [" <<
                  events.front().id() << ',' << (events.back().id() + 1) << ')',
                  "to", a.second, '(' << a.first << ')');
-      auto t = spawn<task>(time::snapshot(), uint64_t{events.size()});
+      auto t = spawn<task>(time::snapshot(), uint64_t{events.size()},
+                           current_sender());
       send(t, supervisor_atom::value, this);
       send(a.second,
            message::concat(current_message(), make_message(std::move(t))));
@@ -226,19 +362,32 @@ behavior index::make_behavior() {
           qs.hist->task
             = spawn<task>(time::snapshot(), expr, historical_atom::value);
           send(qs.hist->task, supervisor_atom::value, this);
+          scheduler_.add(expr, has_low_priority_option(opts)
+                                 ? detail::query_scheduler::low
+                                 : detail::query_scheduler::high);
           // Test whether this query matches any partition and relay it where
-          // possible.
+          // possible. For each partition we cannot relay the query to right
+          // away, INDEX registers itself with the task as a placeholder until
+          // the scheduler loads the partition.
           for (auto& p : partitions_)
-            if (visit(expr::time_restrictor{p.second.from, p.second.to}, expr))
+            if (p.second.events > 0
+                && visit(expr::time_restrictor{p.second.from, p.second.to},
+                         expr)) {
               if (auto a = dispatch(p.first, expr)) {
                 qs.hist->parts.emplace(a->address(), p.first);
                 send(qs.hist->task, *a);
                 send(*a, expr, historical_atom::value);
+              } else {
+                send(qs.hist->task, this);
               }
-          if (qs.hist->parts.empty()) {
+            }
+          if (qs.hist->parts.empty() && scheduler_.pending(expr) == 0) {
             VAST_DEBUG(this, "did not find a qualifying partition for query");
+            remove_query(expr);
             send_exit(qs.hist->task, exit::done);
             qs.hist->task = invalid_actor;
+          } else {
+            schedule();
           }
         }
         send(subscriber, qs.hist->task);
@@ -256,10 +405,17 @@ behavior index::make_behavior() {
           VAST_VERBOSE(this, "enables continuous query");
           qs.cont->task = spawn<task>(time::snapshot());
           send(qs.cont->task, this);
-          // Relay the continuous query to all active partitions, as these may
-          // still receive events.
-          for (auto& a : active_)
-            send(a.second, expr, continuous_atom::value);
+          qs.cont->streaming = has_streaming_option(opts);
+          if (qs.cont->streaming) {
+            if (!streamer_)
+              streamer_ = spawn<continuous_evaluator, monitored>(this);
+            send(streamer_, expr, continuous_atom::value);
+          } else {
+            // Relay the continuous query to all active partitions, as these
+            // may still receive events.
+            for (auto& a : active_)
+              send(a.second, expr, continuous_atom::value);
+          }
         }
         send(subscriber, qs.cont->task);
         if (!qs.cont->hits.empty() && !qs.cont->hits.all_zeros())
@@ -275,15 +431,24 @@ behavior index::make_behavior() {
         VAST_WARN(this, "has already disabled query:", expr);
       } else {
         VAST_VERBOSE(this, "disables continuous query:", expr);
+        if (q->second.cont->streaming)
+          send(streamer_, expr, continuous_atom::value, disable_atom::value);
+        else
+          for (auto& a : active_)
+            send(a.second, expr, continuous_atom::value, disable_atom::value);
         send(q->second.cont->task, done_atom::value);
         q->second.cont->task = invalid_actor;
       }
     },
-    [=](done_atom, time::moment start, uint64_t events) {
+    [=](done_atom, time::moment start, uint64_t events,
+        actor_addr const& importer) {
       VAST_VERBOSE(this, "indexed", events, "events in",
                    time::snapshot() - start);
       if (accountant_)
         send(accountant_, events, time::snapshot());
+      // Let the importer size its credit window from our indexing rate.
+      if (importer)
+        send(actor_cast<actor>(importer), done_atom::value, events);
     },
     [=](done_atom, time::moment start, expression const& expr) {
       auto runtime = time::snapshot() - start;
@@ -314,6 +479,13 @@ behavior index::make_behavior() {
       // so that future queries don't need to start over again.
       q->second.hist->task = invalid_actor;
       queries_.erase(q);
+      remove_query(expr);
+    },
+    [=](get_atom, query_atom) {
+      using prio = detail::query_scheduler::priority;
+      return make_message(uint64_t{scheduler_.queries()},
+                          uint64_t{scheduler_.pending(prio::high)},
+                          uint64_t{scheduler_.pending(prio::low)});
     },
     [=](expression const& expr, bitstream_type& hits, historical_atom) {
       VAST_DEBUG(this, "received", hits.count(), "historical hits from",
@@ -342,90 +514,122 @@ behavior index::make_behavior() {
 }
 
 optional<actor> index::dispatch(uuid const& part, expression const& expr) {
-  if (partitions_[part].events == 0)
-    return {};
-  // If the partition is already scheduled, we add the expression to the set of
-  // to-be-queried expressions.
-  auto schedule_pred = [&](auto& s) { return s.part == part; };
-  auto i = std::find_if(schedule_.begin(), schedule_.end(), schedule_pred);
-  if (i == schedule_.end()) {
-    VAST_DEBUG(this, "enqueues partition", part, "with", expr);
-    schedule_.push_back(index::schedule_state{part, {expr}});
-  } else {
-    VAST_DEBUG(this, "adds expression to", part << ":", expr);
-    i->queries.insert(expr);
-  }
   // If the partition is in memory, we send it the expression directly.
   for (auto& a : active_)
-    if (a.first == part)
+    if (a.first == part) {
+      scheduler_.dispatch(expr, part);
       return a.second;
-  if (auto p = passive_.lookup(part))
+    }
+  if (auto p = passive_.lookup(part)) {
+    scheduler_.dispatch(expr, part);
     return *p;
-  // If we have not fully maxed out our available passive partitions, we can
-  // spawn the partition directly.
-  if (passive_.size() < passive_.capacity()) {
-    VAST_DEBUG(this, "spawns passive partition", part);
-    auto p = spawn<partition, monitored>(dir_ / to_string(part), this);
-    send(p, upstream_atom::value, this);
-    passive_.insert(part, p);
-    return p;
   }
+  VAST_DEBUG(this, "enqueues partition", part, "with", expr);
+  scheduler_.enqueue(expr, part);
   return {};
 }
 
-void index::consolidate(uuid const& part, expression const& expr) {
-  VAST_DEBUG(this, "consolidates", part, "for", expr);
-  auto schedule_pred = [&](auto& s) { return s.part == part; };
-  auto i = std::find_if(schedule_.begin(), schedule_.end(), schedule_pred);
-  // Remove the completed query expression from the schedule.
-  VAST_ASSERT(i != schedule_.end());
-  VAST_ASSERT(!i->queries.empty());
-  auto x = i->queries.find(expr);
-  VAST_ASSERT(x != i->queries.end());
-  i->queries.erase(x);
-  // We keep the partition in the schedule as long it has outstanding queries.
-  if (!i->queries.empty()) {
-    VAST_DEBUG(this, "got completed query", expr, "for partition", part << ',',
-               i->queries.size(), "remaining");
-    return;
-  }
-  VAST_DEBUG(this, "removes partition from schedule:", part);
-  schedule_.erase(i);
-  if (schedule_.empty())
-    VAST_DEBUG(this, "finished with entire schedule");
-  // We never unload active partitions.
-  auto part_pred = [&](auto& a) { return a.first == part; };
-  if (std::find_if(active_.begin(), active_.end(), part_pred) != active_.end())
-    return;
-  // If we're not dealing with an active partition, it must exist in the
-  // passive list, unless we dispatched an expression to an active partition
-  // and that got replaced with a new one. In the latter case the replaced
-  // partition is neither in the active nor passive set and has already being
-  // taken care of, so we can safely ignore this consolidation request.
-  if (passive_.lookup(part) == nullptr)
-    return;
-  // For each consolidated passive partition, we load another new one. Because
-  // partitions can complete in any order, we have to walk through the schedule
-  // from the beginning again to find the next passive partition to load.
-  for (auto& entry : schedule_) {
-    auto entry_pred = [&](auto& a) { return a.first == entry.part; };
-    auto a = std::find_if(active_.begin(), active_.end(), entry_pred);
-    if (a == active_.end() && !passive_.contains(entry.part)) {
-      VAST_DEBUG(this, "schedules next passive partition", entry.part);
-      auto p = spawn<partition, monitored>(dir_ / to_string(entry.part), this);
-      send(p, upstream_atom::value, this);
-      passive_.insert(entry.part, p); // automatically evicts 'part'.
-      for (auto& next_expr : entry.queries) {
-        auto q = queries_.find(next_expr);
-        VAST_ASSERT(q != queries_.end());
-        VAST_ASSERT(q->second.hist);
-        q->second.hist->parts.emplace(p->address(), entry.part);
-        send(q->second.hist->task, p);
-        send(p, next_expr, historical_atom::value);
+void index::schedule() {
+  auto admission = [=](uuid const& part) { return admit(part); };
+  while (auto next = scheduler_.next(admission)) {
+    auto& part = next->first;
+    auto& exprs = next->second;
+    optional<actor> p;
+    for (auto& a : active_)
+      if (a.first == part)
+        p = a.second;
+    if (!p) {
+      if (auto x = passive_.lookup(part)) {
+        p = *x;
+      } else {
+        VAST_DEBUG(this, "schedules next passive partition", part);
+        p = spawn<partition, monitored>(dir_ / to_string(part), this);
+        send(*p, upstream_atom::value, this);
+        passive_.insert(part, *p);
+        passive_bytes_ += partitions_[part].bytes;
+        prefetched_.erase(part);
       }
-      break;
+    }
+    for (auto& expr : exprs) {
+      auto q = queries_.find(expr);
+      VAST_ASSERT(q != queries_.end());
+      VAST_ASSERT(q->second.hist);
+      q->second.hist->parts.emplace(p->address(), part);
+      send(q->second.hist->task, *p);
+      send(q->second.hist->task, done_atom::value, address());
+      send(*p, expr, historical_atom::value);
     }
   }
+  // Warm up the page cache for the partitions which come next, such that they
+  // load quickly once running partitions complete.
+  for (auto& part : scheduler_.peek(scheduler_.max_inflight()))
+    if (!passive_.contains(part) && prefetched_.insert(part).second)
+      send(prefetcher_, part, dir_ / to_string(part));
+  VAST_DEBUG(this, "has", scheduler_.pending(), "partitions enqueued for",
+             scheduler_.queries(), "queries,",
+             passive_.size(), "passive partitions loaded with",
+             passive_bytes_ >> 20, "MB");
+  if (accountant_)
+    send(accountant_, label() + "-queue", uint64_t{scheduler_.pending()},
+         time::snapshot());
+}
+
+void index::remove_query(expression const& expr) {
+  // Partitions which no remaining query waits for will not load soon, so we
+  // may have to prefetch them again later.
+  for (auto& part : scheduler_.remove(expr))
+    prefetched_.erase(part);
+}
+
+bool index::admit(uuid const& part) {
+  for (auto& a : active_)
+    if (a.first == part)
+      return true;
+  if (passive_.contains(part))
+    return true;
+  auto& ps = partitions_[part];
+  if (max_passive_bytes_ > 0 && !ps.measured) {
+    // We hold the partition back until the prefetcher reports its size.
+    if (prefetched_.insert(part).second)
+      send(prefetcher_, part, dir_ / to_string(part));
+    return false;
+  }
+  auto fits = [&] {
+    if (passive_.size() == passive_.capacity())
+      return false;
+    // A partition exceeding the entire budget can still load on its own.
+    return max_passive_bytes_ == 0 || passive_.empty()
+           || passive_bytes_ + ps.bytes <= max_passive_bytes_;
+  };
+  while (!fits()) {
+    // Make room by evicting the least recently used idle partition.
+    optional<uuid> victim;
+    for (auto p : passive_)
+      if (!scheduler_.busy(p.first))
+        victim = p.first;
+    if (!victim)
+      return false;
+    evict(*victim);
+  }
+  return true;
+}
+
+void index::evict(uuid const& part) {
+  auto p = passive_.lookup(part);
+  VAST_ASSERT(p);
+  VAST_DEBUG(this, "evicts idle partition", part);
+  send_exit(*p, exit::stop);
+  passive_bytes_ -= partitions_[part].bytes;
+  passive_.erase(part);
+}
+
+void index::consolidate(uuid const& part, expression const& expr) {
+  VAST_DEBUG(this, "consolidates", part, "for", expr);
+  // We do not unload passive partitions eagerly, but only when the scheduler
+  // needs room for a new one. This keeps recently used partitions warm.
+  if (scheduler_.complete(expr, part))
+    VAST_DEBUG(this, "has no more queries for partition", part);
+  schedule();
 }
 
 void index::flush() {
@@ -1,7 +1,6 @@
 #ifndef VAST_INDEX_H
 #define VAST_INDEX_H
 
-#include <list>
 #include <map>
 #include <unordered_map>
 
@@ -11,6 +10,7 @@
 #include "vast/uuid.h"
 #include "vast/time.h"
 #include "vast/actor/actor.h"
+#include "vast/detail/query_scheduler.h"
 #include "vast/util/cache.h"
 #include "vast/util/flat_set.h"
 
@@ -37,6 +37,18 @@ namespace vast {
 ///
 /// After receiving the DONE atom the sink will not receive any further hits.
 /// This sequence applies both to continuous and historical queries.
+///
+/// Historical queries which require partitions not in memory go through a
+/// scheduler which prefers interactive over low-priority queries, interleaves
+/// partitions across queries of the same priority, and bounds the number of
+/// partitions a single query can occupy concurrently. Passive partitions load
+/// in parallel as long as they fit into a memory budget, which the index
+/// estimates from their size on disk. While partitions evaluate, the index
+/// asks the operating system to prefetch the ones scheduled next.
+///
+/// Continuous queries with the *streaming* option bypass the partitions.
+/// Instead, a dedicated actor evaluates them directly on the arriving event
+/// batches, so that their latency does not depend on indexing.
 struct index : public flow_controlled_actor {
   // FIXME: only propagate overload upstream if *all* partitions are
   // overloaded. This requires tracking the set of overloaded partitions
@@ -44,21 +56,19 @@ struct index : public flow_controlled_actor {
 
   using bitstream_type = default_bitstream;
 
-  struct schedule_state {
-    uuid part;
-    util::flat_set<expression> queries;
-  };
-
   struct partition_state {
     uint64_t events = 0;
     time::point last_modified;
     time::point from = time::duration{};
     time::point to = time::duration{};
+    uint64_t bytes = 0;    // Not persisted; measured by the prefetcher.
+    bool measured = false;
   };
 
   struct continuous_query_state {
     bitstream_type hits;
     caf::actor task;
+    bool streaming = false;
   };
 
   struct historical_query_state {
@@ -77,22 +87,47 @@ struct index : public flow_controlled_actor {
   /// @param dir The directory of the index.
   /// @param max_events The maximum number of events per partition.
   /// @param passive_parts The maximum number of passive partitions to hold in
-  ///                      memory.
+  ///                      memory, or 0 for no limit.
   /// @param active_parts The number of active partitions to hold in memory.
-  /// @pre `passive_parts > 0 && active_parts > 0`
+  /// @param query_parts The maximum number of partitions a single historical
+  ///                    query can have loaded at the same time.
+  /// @param passive_bytes The memory budget for passive partitions in bytes,
+  ///                      or 0 for no budget.
+  /// @pre `active_parts > 0 && query_parts > 0`
   index(path const& dir, size_t max_events, size_t passive_parts,
-        size_t active_parts);
+        size_t active_parts, size_t query_parts = 5,
+        uint64_t passive_bytes = 0);
 
   void on_exit() override;
   caf::behavior make_behavior() override;
 
   /// Dispatches a query for a partition either by relaying it directly if
-  /// active or enqueing it into partition queue.
+  /// the partition is in memory or enqueing it into scheduler.
   /// @param part The partition to query with *expr*.
   /// @param expr The query to look for in *part*.
-  /// @returns The partition actor for *part* if *expr* can be scheduled.
+  /// @returns The partition actor for *part* if it is in memory.
   optional<caf::actor> dispatch(uuid const& part, expression const& expr);
 
+  /// Loads enqueued partitions as long as there is room for passive
+  /// partitions, relays the waiting queries to them, and prefetches the
+  /// partitions due next.
+  void schedule();
+
+  /// Checks whether a partition can be loaded without exceeding the limits
+  /// for passive partitions, evicting idle passive partitions as needed.
+  /// @param part The partition to check.
+  /// @returns `true` iff *part* is in memory or fits into memory.
+  bool admit(uuid const& part);
+
+  /// Removes a historical query from the scheduler and forgets the prefetched
+  /// partitions that only this query waited for.
+  /// @param expr The query to remove.
+  void remove_query(expression const& expr);
+
+  /// Unloads a passive partition.
+  /// @param part The passive partition to unload.
+  void evict(uuid const& part);
+
   /// Consolidates a query which has previously been dispatched.
   /// @param part The partition of *expr*.
   /// @param expr The query which has finished with *part*.
@@ -106,8 +141,13 @@ struct index : public flow_controlled_actor {
   caf::actor accountant_;
   std::map<expression, query_state> queries_;
   std::unordered_map<uuid, partition_state> partitions_;
-  std::list<schedule_state> schedule_;
+  detail::query_scheduler scheduler_;
   util::cache<uuid, caf::actor, util::mru> passive_;
+  uint64_t passive_bytes_ = 0;
+  uint64_t max_passive_bytes_;
+  caf::actor prefetcher_;
+  caf::actor streamer_;
+  util::flat_set<uuid> prefetched_;
   std::vector<std::pair<uuid, caf::actor>> active_;
   size_t next_active_ = 0;
 };
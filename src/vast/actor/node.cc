@@ -325,12 +325,17 @@ behavior node::spawn_actor(event_based_actor* self) {
       },
       on("index", any_vals) >> [=] {
         uint64_t events = 1 << 20;
-        uint64_t passive = 10;
+        uint64_t passive = 0;
         uint64_t active = 5;
+        uint64_t query_parts = 5;
+        uint64_t memory = 1024;
         auto r = self->current_message().extract_opts({
           {"events,e", "maximum events per partition", events},
           {"active,a", "maximum active partitions", active},
-          {"passive,p", "maximum passive partitions", passive}
+          {"passive,p", "maximum passive partitions (0 = unlimited)", passive},
+          {"query-partitions,q", "maximum loaded partitions per query",
+           query_parts},
+          {"memory,m", "memory budget for passive partitions in MB", memory}
         });
         if (!r.error.empty()) {
           rp.deliver(make_message(error{std::move(r.error)}));
@@ -338,12 +343,22 @@ behavior node::spawn_actor(event_based_actor* self) {
           return;
         }
         auto dir = dir_ / "index";
-        auto idx = spawn<index, priority_aware>(dir, events, passive, active);
+        auto idx = spawn<index, priority_aware>(dir, events, passive, active,
+                                                query_parts, memory << 20);
         self->send(idx, put_atom::value, accountant_atom::value, accountant_);
         save_actor(std::move(idx), "index");
       },
-      on("importer") >> [=] {
-        auto imp = spawn<importer, priority_aware>();
+      on("importer", any_vals) >> [=] {
+        auto lease_size = event_id{1 << 16};
+        auto r = self->current_message().drop(1).extract_opts({
+          {"lease-size,n", "the number of IDs to lease at once", lease_size}
+        });
+        if (!r.error.empty()) {
+          rp.deliver(make_message(error{std::move(r.error)}));
+          self->quit(exit::error);
+          return;
+        }
+        auto imp = spawn<importer, priority_aware>(lease_size);
         // send(imp, put_atom::value, accountant_atom::value, accountant_);
         save_actor(std::move(imp), "importer");
       },
@@ -355,6 +370,8 @@ behavior node::spawn_actor(event_based_actor* self) {
           {"continuous,c", "marks a query as continuous"},
           {"historical,h", "marks a query as historical"},
           {"unified,u", "marks a query as unified"},
+          {"low-priority,l", "schedules a query as batch query"},
+          {"streaming,s", "evaluates a continuous query on raw events"},
           {"auto-connect,a", "connect to available archives & indexes"}
         });
         if (!r.error.empty())
@@ -378,12 +395,16 @@ behavior node::spawn_actor(event_based_actor* self) {
           query_opts = query_opts + historical;
         if (r.opts.count("unified") > 0)
           query_opts = unified;
+        if (r.opts.count("streaming") > 0)
+          query_opts = query_opts + continuous + streaming;
         if (query_opts == no_query_options) {
           VAST_ERROR(this, "got query without options (-h, -c, -u)");
           rp.deliver(make_message(error{"missing query options (-h, -c, -u)"}));
           self->quit(exit::error);
           return;
         }
+        if (r.opts.count("low-priority") > 0)
+          query_opts = query_opts + low_priority;
         VAST_DEBUG(this, "parses expression");
         auto expr = detail::to_expression(str);
         if (!expr) {
@@ -1,3 +1,6 @@
+#include <memory>
+#include <unordered_map>
+
 #include <caf/all.hpp>
 
 #include "vast/event.h"
@@ -21,8 +24,63 @@ namespace vast {
 
 namespace {
 
-// Accumulates all hits from an event batch, evalutes a query, and sends the
-// result of the evaluation to PARTITION.
+// Checks whether a predicate can possibly yield hits for events of a given
+// type. The check errs on the side of caution: if in doubt, the predicate
+// matches.
+struct type_matcher {
+  type_matcher(type const& t) : type_{t} {
+  }
+
+  bool operator()(predicate const& p) {
+    op_ = p.op;
+    return visit(*this, p.lhs, p.rhs);
+  }
+
+  template <typename T, typename U>
+  bool operator()(T const&, U const&) const {
+    return true;
+  }
+
+  bool operator()(event_extractor const&, data const& d) const {
+    if (op_ != equal)
+      return true;
+    auto name = get<std::string>(d);
+    return !name || *name == type_.name();
+  }
+
+  bool operator()(type_extractor const& e, data const&) const {
+    if (auto r = get<type::record>(type_)) {
+      for (auto& i : type::record::each{*r})
+        if (i.trace.back()->type == e.type)
+          return true;
+      return false;
+    }
+    return type_ == e.type;
+  }
+
+  bool operator()(schema_extractor const& e, data const&) const {
+    if (auto r = get<type::record>(type_))
+      return !r->find_suffix(e.key).empty();
+    return e.key.size() == 1 && pattern::glob(e.key[0]).match(type_.name());
+  }
+
+  bool operator()(data_extractor const& e, data const&) const {
+    return e.type == type_;
+  }
+
+  template <typename T>
+  bool operator()(data const& d, T const& e) const {
+    return (*this)(e, d);
+  }
+
+  type const& type_;
+  relational_operator op_;
+};
+
+// Evaluates continuous queries on event batches. For each batch, it asks
+// only those indexers for hits which can match a predicate, accumulates the
+// hits per batch, evalutes all queries once the batch has completed, and
+// sends the result of the evaluation to PARTITION.
 template <typename Bitstream>
 struct continuous_query_proxy : default_actor {
   using predicate_map = std::map<predicate, Bitstream>;
@@ -40,41 +98,12 @@ struct continuous_query_proxy : default_actor {
     predicate_map const& map_;
   };
 
-  // Accumulates hits from indexers for a single event batch.
-  struct accumulator : default_actor {
-    accumulator(std::vector<expression> exprs, actor sink)
-      : default_actor{"accumulator"},
-        exprs_{std::move(exprs)},
-        sink_{std::move(sink)} {
-    }
-
-    void on_exit() override {
-      sink_ = invalid_actor;
-    }
-
-    behavior make_behavior() override {
-      return {
-        [=](expression& pred, Bitstream& hits) {
-          auto p = get<predicate>(pred);
-          VAST_ASSERT(p);
-          map_.emplace(std::move(*p), std::move(hits));
-        },
-        [=](done_atom) {
-          for (auto& expr : exprs_) {
-            VAST_DEBUG(this, "evalutes continuous query:", expr);
-            send(sink_, expr, visit(evaluator{map_}, expr));
-          }
-          quit(exit::done);
-          // TODO: relay predicate_map back to PARTITION if the query is also
-          // historical. Caveat: we should not re-evaluate the historical query
-          // with these hits to avoid that the sink receives duplicate hits.
-        }
-      };
-    }
-
-    predicate_map map_;
-    std::vector<expression> exprs_;
-    actor sink_;
+  // The hits of a single event batch.
+  struct batch_state {
+    // The queries at the time the batch arrived. Queries registered later
+    // did not have their predicates looked up for this batch.
+    std::shared_ptr<std::vector<expression> const> exprs;
+    predicate_map hits;
   };
 
   continuous_query_proxy(actor sink)
@@ -83,53 +112,122 @@ struct continuous_query_proxy : default_actor {
 
   void on_exit() override {
     sink_ = invalid_actor;
+    batches_.clear();
   }
 
   behavior make_behavior() override {
     return {
       [=](expression const& expr) {
-        exprs_.insert(expr);
-        for (auto& p : visit(expr::predicatizer{}, expr))
-          preds_.insert(std::move(p));
+        if (exprs_.insert(expr).second)
+          update();
       },
       [=](expression const& expr, disable_atom) {
         exprs_.erase(expr);
-        preds_.clear();
         if (exprs_.empty())
           quit(exit::done);
         else
-          for (auto& ex : exprs_)
-            for (auto& p : visit(expr::predicatizer{}, ex))
-              preds_.insert(std::move(p));
+          update();
       },
-      [=](expression& expr, Bitstream& hits) {
-        VAST_DEBUG(this, "relays", hits.count(), "hits");
-        send(sink_, std::move(expr), std::move(hits),
-             continuous_atom::value);
+      [=](expression const& pred, Bitstream& hits) {
+        // The hits of a batch cover only the ID range of the batch. If the
+        // bitstream has no hits, its size still tells us the batch.
+        auto pos = hits.find_first();
+        if (pos == Bitstream::npos) {
+          if (hits.empty())
+            return;
+          pos = hits.size() - 1;
+        }
+        auto b = batches_.upper_bound(pos);
+        if (b == batches_.begin()) {
+          VAST_WARN(this, "ignores hits for unknown batch:", pred);
+          return;
+        }
+        --b;
+        auto p = get<predicate>(pred);
+        VAST_ASSERT(p);
+        auto i = b->second.hits.find(*p);
+        if (i == b->second.hits.end())
+          b->second.hits.emplace(*p, std::move(hits));
+        else
+          i->second |= hits;
       },
-      [=](std::vector<actor> const& indexers) {
+      [=](done_atom, event_id base) {
+        auto b = batches_.find(base);
+        VAST_ASSERT(b != batches_.end());
+        for (auto& expr : *b->second.exprs) {
+          VAST_DEBUG(this, "evalutes continuous query:", expr);
+          auto hits = visit(evaluator{b->second.hits}, expr);
+          if (!hits.empty() && !hits.all_zeros()) {
+            VAST_DEBUG(this, "relays", hits.count(), "hits");
+            send(sink_, expr, std::move(hits), continuous_atom::value);
+          }
+        }
+        batches_.erase(b);
+        // TODO: relay predicate_map back to PARTITION if the query is also
+        // historical. Caveat: we should not re-evaluate the historical query
+        // with these hits to avoid that the sink receives duplicate hits.
+      },
+      [=](event_id base, std::vector<actor> const& indexers,
+          std::vector<type> const& types) {
+        VAST_ASSERT(indexers.size() == types.size());
         VAST_DEBUG(this, "got", indexers.size(), "indexers");
         if (exprs_.empty()) {
           VAST_WARN(this, "got indexers without having queries");
           return;
         }
-        // FIXME: do not stupidly send every predicate to every indexer,
-        // rather, pick the minimal subset intelligently.
-        auto acc = spawn<accumulator>(exprs_.as_vector(), this);
-        auto t = spawn<task>();
-        send(t, supervisor_atom::value, acc);
-        for (auto& i : indexers) {
-          send(t, i, uint64_t{preds_.size()});
-          for (auto& p : preds_)
-            send(i, expression{p}, acc, t);
+        actor t;
+        for (size_t i = 0; i < indexers.size(); ++i) {
+          auto& preds = route(types[i]);
+          if (preds.empty())
+            continue;
+          if (!t) {
+            t = spawn<task>(base);
+            send(t, supervisor_atom::value, this);
+            batches_[base].exprs = snapshot_;
+          }
+          send(t, indexers[i], uint64_t{preds.size()});
+          for (auto& p : preds)
+            send(indexers[i], expression{p}, this, t);
         }
+        if (!t)
+          VAST_DEBUG(this, "found no indexer matching any predicate");
       }
     };
   }
 
+  // Recomputes the deduplicated predicates of all queries.
+  void update() {
+    preds_.clear();
+    for (auto& expr : exprs_)
+      for (auto& p : visit(expr::predicatizer{}, expr))
+        preds_.insert(std::move(p));
+    routes_.clear();
+    snapshot_ = std::make_shared<std::vector<expression> const>(
+      exprs_.as_vector());
+    VAST_DEBUG(this, "has", preds_.size(), "unique predicates for",
+               exprs_.size(), "queries");
+  }
+
+  // Retrieves the predicates which can match events of a given type.
+  std::vector<predicate> const& route(type const& t) {
+    auto i = routes_.find(t);
+    if (i != routes_.end())
+      return i->second;
+    auto& preds = routes_[t];
+    for (auto& p : preds_) {
+      type_matcher matcher{t};
+      if (matcher(p))
+        preds.push_back(p);
+    }
+    return preds;
+  }
+
   actor sink_;
   util::flat_set<expression> exprs_;
   util::flat_set<predicate> preds_;
+  std::unordered_map<type, std::vector<predicate>> routes_;
+  std::shared_ptr<std::vector<expression> const> snapshot_;
+  std::map<event_id, batch_state> batches_;
 };
 
 } // namespace <anonymous>
@@ -281,21 +379,36 @@ behavior partition::make_behavior() {
         send(task, i);
         send(i, current_message());
       }
-      if (proxy_ != invalid_actor)
-        send(proxy_, std::move(indexers));
-      events_indexed_concurrently_ += events.size();
-      if (++events_indexed_concurrently_ > 1 << 20) // TODO: calibrate
+      if (proxy_ != invalid_actor) {
+        std::vector<type> indexer_types;
+        for (auto& t : types)
+          if (!t.find_attribute(type::attribute::skip))
+            indexer_types.push_back(t);
+        send(proxy_, base, std::move(indexers), std::move(indexer_types));
+      }
+      // All indexers share the batch, which lives until the last one has
+      // processed it. We account for its memory until then.
+      auto bytes = uint64_t{0};
+      for (auto& e : events)
+        bytes += footprint(e);
+      batch_bytes_[task.address()] = bytes;
+      bytes_indexed_concurrently_ += bytes;
+      if (bytes_indexed_concurrently_ > max_bytes_indexed_concurrently)
         overloaded(true);
       send(task, supervisor_atom::value, this);
-      VAST_DEBUG(this, "indexes", events_indexed_concurrently_,
-                 "events in parallel");
+      VAST_DEBUG(this, "indexes", bytes_indexed_concurrently_,
+                 "bytes of events in parallel");
     },
     [=](done_atom, time::moment start, uint64_t events) {
       VAST_DEBUG(this, "indexed", events, "events in",
                  time::snapshot() - start);
-      VAST_ASSERT(events_indexed_concurrently_ > events);
-      events_indexed_concurrently_ -= events;
-      if (events_indexed_concurrently_ < 1 << 20)
+      auto i = batch_bytes_.find(current_sender());
+      if (i == batch_bytes_.end())
+        return;
+      VAST_ASSERT(bytes_indexed_concurrently_ >= i->second);
+      bytes_indexed_concurrently_ -= i->second;
+      batch_bytes_.erase(i);
+      if (bytes_indexed_concurrently_ <= max_bytes_indexed_concurrently)
         overloaded(false);
     },
     [=](expression const& expr, continuous_atom) {
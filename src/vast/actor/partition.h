@@ -16,10 +16,16 @@ namespace vast {
 /// A horizontal partition of the index.
 ///
 /// For each event batch PARTITION receives, it spawns one EVENT_INDEXERs per
-/// type occurring in the batch and forwards them the events.
+/// type occurring in the batch and forwards them the events. All indexers
+/// share the same immutable batch. PARTITION accounts for the memory of the
+/// batches its indexers still hold and signals overload when they exceed a
+/// budget.
 struct partition : flow_controlled_actor {
   using bitstream_type = default_bitstream;
 
+  /// The memory budget for batches being indexed, in bytes.
+  static constexpr uint64_t max_bytes_indexed_concurrently = 512 << 20;
+
   struct evaluator : expr::bitstream_evaluator<evaluator, default_bitstream> {
     evaluator(partition const& p);
     bitstream_type const* lookup(predicate const& pred) const;
@@ -54,7 +60,8 @@ struct partition : flow_controlled_actor {
   caf::actor sink_;
   caf::actor proxy_;
   schema schema_;
-  size_t events_indexed_concurrently_ = 0;
+  uint64_t bytes_indexed_concurrently_ = 0;
+  std::map<caf::actor_addr, uint64_t> batch_bytes_;
   std::multimap<event_id, caf::actor> indexers_;
   std::map<expression, query_state> queries_;
   std::map<predicate, predicate_state> predicates_;
@@ -0,0 +1,96 @@
+#include "vast/actor/sink/arrow.h"
+#include "vast/concept/printable/vast/error.h"
+#include "vast/concept/printable/vast/filesystem.h"
+#include "vast/io/algorithm.h"
+#include "vast/util/assert.h"
+
+namespace vast {
+namespace sink {
+
+arrow::arrow(path p, size_t rows) : base<arrow>{"arrow-sink"}, rows_{rows} {
+  VAST_ASSERT(rows_ > 0);
+  // An empty directory means we write to standard output.
+  if (p != "-")
+    dir_ = std::move(p);
+  attach_functor([=](uint32_t) {
+    std::string eos;
+    detail::arrow_writer::write_eos(eos);
+    for (auto& p : streams_)
+      if (p.second->out && write_batch(*p.second))
+        io::copy(eos.begin(), eos.end(), *p.second->out);
+    streams_.clear();
+  });
+}
+
+bool arrow::process_batch(batch events) {
+  // Record batches span multiple messages, because the exporter may deliver
+  // only a few events at a time.
+  for (auto& e : events) {
+    auto s = get_stream(e.type());
+    if (!s)
+      return false;
+    s->writer.add(e);
+    if (s->writer.rows() == rows_ && !write_batch(*s))
+      return false;
+  }
+  return true;
+}
+
+void arrow::flush() {
+  for (auto& p : streams_)
+    if (p.second->out && write_batch(*p.second))
+      p.second->out->flush();
+}
+
+arrow::stream* arrow::get_stream(type const& t) {
+  auto i = streams_.find(t.name());
+  if (i != streams_.end()) {
+    if (i->second->type != t) {
+      VAST_ERROR(this, "got events of different types named", t.name());
+      return nullptr;
+    }
+    return i->second.get();
+  }
+  auto s = std::make_unique<stream>(t);
+  if (dir_.empty()) {
+    if (!streams_.empty()) {
+      VAST_ERROR(this, "cannot write events of multiple types to STDOUT");
+      return nullptr;
+    }
+    VAST_DEBUG(this, "creates a new stream for STDOUT");
+    s->out = std::make_unique<io::file_output_stream>("-");
+  } else {
+    VAST_DEBUG(this, "creates new stream for event", t.name());
+    if (!exists(dir_)) {
+      auto d = mkdir(dir_);
+      if (!d) {
+        VAST_ERROR(this, "failed to create directory:", d.error());
+        return nullptr;
+      }
+    } else if (!dir_.is_directory()) {
+      VAST_ERROR(this, "got existing non-directory path:", dir_);
+      return nullptr;
+    }
+    auto filename = dir_ / (t.name() + ".arrow");
+    s->out = std::make_unique<io::file_output_stream>(filename);
+  }
+  std::string schema;
+  s->writer.write_schema(schema);
+  if (!io::copy(schema.begin(), schema.end(), *s->out))
+    return nullptr;
+  return streams_.emplace(t.name(), std::move(s)).first->second.get();
+}
+
+bool arrow::write_batch(stream& s) {
+  if (s.writer.rows() == 0)
+    return true;
+  s.writer.write_batch(buffer_);
+  auto written = io::copy(buffer_.begin(), buffer_.end(), *s.out);
+  buffer_.clear();
+  if (!written)
+    VAST_ERROR(this, "failed to write record batch for", s.type.name());
+  return written;
+}
+
+} // namespace sink
+} // namespace vast
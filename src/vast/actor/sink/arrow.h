@@ -0,0 +1,58 @@
+#ifndef VAST_ACTOR_SINK_ARROW_H
+#define VAST_ACTOR_SINK_ARROW_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "vast/filesystem.h"
+#include "vast/type.h"
+#include "vast/detail/arrow_writer.h"
+#include "vast/io/file_stream.h"
+#include "vast/actor/sink/base.h"
+
+namespace vast {
+namespace sink {
+
+/// A sink generating Arrow IPC streams. Since a stream has a single schema,
+/// the sink writes one stream per event type. Events accumulate into record
+/// batches of a fixed number of rows, and a flush writes out the remainder.
+class arrow : public base<arrow> {
+public:
+  /// Spawns an Arrow sink.
+  /// @param p The output directory, or `-` to write a single stream to
+  ///          standard output.
+  /// @param rows The maximum number of events per record batch.
+  arrow(path p, size_t rows = 65536);
+
+  bool process_batch(batch events);
+
+  void flush();
+
+private:
+  struct stream {
+    stream(vast::type const& t) : type{t}, writer{t} {
+    }
+
+    vast::type type;
+    detail::arrow_writer writer;
+    std::unique_ptr<io::file_output_stream> out;
+  };
+
+  // Retrieves the stream for events of a given type, creating it and writing
+  // the schema on first use.
+  stream* get_stream(type const& t);
+
+  // Writes the current record batch of a stream.
+  bool write_batch(stream& s);
+
+  path dir_;
+  size_t rows_;
+  std::unordered_map<std::string, std::unique_ptr<stream>> streams_;
+  std::string buffer_;
+};
+
+} // namespace sink
+} // namespace vast
+
+#endif
@@ -12,9 +12,15 @@ ascii::ascii(std::unique_ptr<std::ostream> out)
   VAST_ASSERT(out_ != nullptr);
 }
 
-bool ascii::process(event const& e) {
-  auto i = std::ostreambuf_iterator<std::ostream::char_type>{*out_};
-  return print(i, e) && print(i, '\n');
+bool ascii::process_batch(batch events) {
+  // Formatting the whole batch into one buffer bypasses the stream
+  // machinery for each character.
+  buffer_.clear();
+  auto i = std::back_inserter(buffer_);
+  for (auto& e : events)
+    if (!(print(i, e) && print(i, '\n')))
+      return false;
+  return static_cast<bool>(out_->write(buffer_.data(), buffer_.size()));
 }
 
 void ascii::flush() {
@@ -3,6 +3,7 @@
 
 #include <iosfwd>
 #include <memory>
+#include <string>
 
 #include "vast/actor/sink/base.h"
 
@@ -16,12 +17,13 @@ public:
   /// @param out The output stream.
   ascii(std::unique_ptr<std::ostream> out);
 
-  bool process(event const& e);
+  bool process_batch(batch events);
 
   void flush();
 
 private:
   std::unique_ptr<std::ostream> out_;
+  std::string buffer_;
 };
 
 } // namespace sink
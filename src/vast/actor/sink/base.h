@@ -9,14 +9,20 @@
 #include "vast/event.h"
 #include "vast/time.h"
 #include "vast/uuid.h"
+#include "vast/util/range.h"
 
 namespace vast {
 namespace sink {
 
-/// The base class for event sinks.
+/// The base class for event sinks. A sink implements either
+/// `bool process(event const&)` to handle one event at a time, or
+/// `bool process_batch(batch)` to handle a contiguous range of events at once.
 template <typename Derived>
 class base : public default_actor {
 public:
+  /// A contiguous range of events.
+  using batch = util::iterator_range<event const*>;
+
   base(char const* name = "sink") : default_actor{name} {
     trap_exit(true);
   }
@@ -44,14 +50,16 @@ public:
         accountant_ = accountant;
         send(accountant_, label() + "-events", time::now());
       },
-      [=](uuid const&, event const& e) { handle(e); },
+      [=](uuid const&, event const& e) { handle(batch{&e, &e + 1}); },
       [=](uuid const&, std::vector<event> const& v) {
-        assert(!v.empty());
-        for (auto& e : v)
-          if (!handle(e))
-            return;
+        VAST_ASSERT(!v.empty());
+        auto n = v.size();
+        if (limit_ > 0 && limit_ - processed_ < n)
+          n = limit_ - processed_;
+        if (!handle(batch{v.data(), v.data() + n}))
+          return;
         if (accountant_)
-          send(accountant_, static_cast<uint64_t>(v.size()), time::snapshot());
+          send(accountant_, static_cast<uint64_t>(n), time::snapshot());
       },
       [=](uuid const& id, progress_atom, double progress, uint64_t total_hits) {
         VAST_VERBOSE(this, "got progress from query ", id << ':', total_hits,
@@ -68,17 +76,28 @@ protected:
     // Nothing by default.
   }
 
+  bool process_batch(batch events) {
+    for (auto& e : events)
+      if (!static_cast<Derived*>(this)->process(e)) {
+        VAST_ERROR(this, "failed to process event:", e);
+        return false;
+      }
+    return true;
+  }
+
 private:
-  bool handle(event const& e) {
-    if (!static_cast<Derived*>(this)->process(e)) {
-      VAST_ERROR(this, "failed to process event:", e);
+  bool handle(batch events) {
+    if (!static_cast<Derived*>(this)->process_batch(events)) {
+      VAST_ERROR(this, "failed to process batch");
       this->quit(exit::error);
       return false;
     }
-    if (++processed_ == limit_) {
+    processed_ += events.end() - events.begin();
+    if (processed_ == limit_) {
       VAST_VERBOSE(this, "reached limit: ", limit_, "events");
       this->quit(exit::done);
     }
+    // Querying the clock once per batch suffices.
     auto now = time::snapshot();
     if (now - last_flush_ > flush_interval_) {
       static_cast<Derived*>(this)->flush();
@@ -57,84 +57,119 @@ bro::bro(path p) : base<bro>{"bro-sink"} {
 
 namespace {
 
+// Appends the Bro log representation of data to a buffer.
 struct value_printer {
-  using result_type = std::string;
+  value_printer(std::string& out) : out_{out} {
+  }
 
-  std::string operator()(none) const {
-    return bro::unset_field;
+  void operator()(none) const {
+    out_ += bro::unset_field;
   }
 
   template <typename T>
-  std::string operator()(T&& x) const {
-    return to_string(x);
+  auto operator()(T const& x) const
+    -> std::enable_if_t<
+         !(std::is_same<T, vector>::value || std::is_same<T, set>::value)
+       > {
+    auto i = std::back_inserter(out_);
+    print(i, x);
   }
 
-  std::string operator()(integer i) const {
-    return std::to_string(i);
+  void operator()(integer i) const {
+    out_ += std::to_string(i);
   }
 
-  std::string operator()(count c) const {
-    return std::to_string(c);
+  void operator()(count c) const {
+    out_ += std::to_string(c);
   }
 
-  std::string operator()(real r) const {
-    std::string str;
-    auto out = std::back_inserter(str);
-    real_printer<real, 6>{}.print(out, r);
-    return str;
+  void operator()(real r) const {
+    auto i = std::back_inserter(out_);
+    real_printer<real, 6>{}.print(i, r);
   }
 
-  std::string operator()(time::point point) const {
-    return (*this)(point.time_since_epoch());
+  void operator()(time::point point) const {
+    (*this)(point.time_since_epoch());
   }
 
-  std::string operator()(time::duration dur) const {
+  void operator()(time::duration dur) const {
     double d;
     convert(dur, d);
-    return (*this)(d);
+    (*this)(d);
   }
 
-  std::string operator()(std::string const& str) const {
-    return str;
+  void operator()(std::string const& str) const {
+    out_ += str;
   }
 
-  std::string operator()(port const& p) const {
-    return std::to_string(p.number());
+  void operator()(port const& p) const {
+    out_ += std::to_string(p.number());
   }
 
-  std::string operator()(record const& r) const {
-    auto visitor = this;
-    return util::join(r.begin(), r.end(), std::string{bro::sep},
-                      [&](auto& d) { return visit(*visitor, d); });
+  void operator()(record const& r) const {
+    for (auto i = r.begin(); i != r.end(); ++i) {
+      if (i != r.begin())
+        out_ += bro::sep;
+      visit(*this, *i);
+    }
   }
 
   template <typename C>
   auto operator()(C const& c) const
     -> std::enable_if_t<
-         std::is_same<C, vector>::value || std::is_same<C, set>::value,
-         std::string
-        > {
-    if (c.empty())
-      return bro::empty_field;
-    auto visitor = this;
-    return util::join(c.begin(), c.end(), bro::set_separator,
-                      [&](auto& x) { return visit(*visitor, x); });
+         std::is_same<C, vector>::value || std::is_same<C, set>::value
+       > {
+    if (c.empty()) {
+      out_ += bro::empty_field;
+      return;
+    }
+    for (auto i = c.begin(); i != c.end(); ++i) {
+      if (i != c.begin())
+        out_ += bro::set_separator;
+      visit(*this, *i);
+    }
   }
 
-  std::string operator()(table const&) const {
-    return bro::unset_field; // Not yet supported by Bro.
+  void operator()(table const&) const {
+    out_ += bro::unset_field; // Not yet supported by Bro.
   }
+
+  std::string& out_;
 };
 
 } // namespace <anonymous>
 
-bool bro::process(event const& e) {
-  auto& t = e.type();
+bool bro::process_batch(batch events) {
+  // We format consecutive events of the same log into one buffer, and write
+  // it when the log changes or the batch ends. The streams get flushed only
+  // periodically through flush().
+  io::file_output_stream* current = nullptr;
+  for (auto& e : events) {
+    auto os = stream(e.type());
+    if (!os)
+      return false;
+    if (os != current) {
+      if (current && !write(*current))
+        return false;
+      current = os;
+    }
+    visit(value_printer{buffer_}, e);
+    buffer_ += '\n';
+  }
+  return !current || write(*current);
+}
+
+void bro::flush() {
+  for (auto& p : streams_)
+    if (p.second)
+      p.second->flush();
+}
+
+io::file_output_stream* bro::stream(type const& t) {
   if (!is<type::record>(t)) {
     VAST_ERROR(this, "cannot process non-record events");
-    return false;
+    return nullptr;
   }
-  io::file_output_stream* os = nullptr;
   if (dir_.empty()) {
     if (streams_.empty()) {
       VAST_DEBUG(this, "creates a new stream for STDOUT");
@@ -142,42 +177,38 @@ bool bro::process(event const& e) {
       auto i = streams_.emplace("", std::move(fos));
       auto header = make_header(t);
       if (!io::copy(header.begin(), header.end(), *i.first->second))
-        return false;
+        return nullptr;
     }
-    os = streams_.begin()->second.get();
-  } else {
-    auto i = streams_.find(t.name());
-    if (i != streams_.end()) {
-      os = i->second.get();
-      VAST_ASSERT(os != nullptr);
-    } else {
-      VAST_DEBUG(this, "creates new stream for event", t.name());
-      if (!exists(dir_)) {
-        auto d = mkdir(dir_);
-        if (!d) {
-          VAST_ERROR(this, "failed to create directory:", d.error());
-          quit(exit::error);
-          return false;
-        }
-      } else if (!dir_.is_directory()) {
-        VAST_ERROR(this, "got existing non-directory path:", dir_);
-        quit(exit::error);
-        return false;
-      }
-      auto filename = dir_ / (t.name() + ".log");
-      auto fos = std::make_unique<io::file_output_stream>(filename);
-      auto header = make_header(t);
-      if (!(io::copy(header.begin(), header.end(), *fos) && fos->flush()))
-        return false;
-      auto i = streams_.emplace("", std::move(fos));
-      os = i.first->second.get();
+    return streams_.begin()->second.get();
+  }
+  auto i = streams_.find(t.name());
+  if (i != streams_.end()) {
+    VAST_ASSERT(i->second != nullptr);
+    return i->second.get();
+  }
+  VAST_DEBUG(this, "creates new stream for event", t.name());
+  if (!exists(dir_)) {
+    auto d = mkdir(dir_);
+    if (!d) {
+      VAST_ERROR(this, "failed to create directory:", d.error());
+      return nullptr;
     }
+  } else if (!dir_.is_directory()) {
+    VAST_ERROR(this, "got existing non-directory path:", dir_);
+    return nullptr;
   }
-  VAST_ASSERT(os != nullptr);
-  auto str = visit(value_printer{}, e);
-  str += '\n';
-  // FIXME: don't flush on every event!
-  return io::copy(str.begin(), str.end(), *os) && os->flush();
+  auto filename = dir_ / (t.name() + ".log");
+  auto fos = std::make_unique<io::file_output_stream>(filename);
+  auto header = make_header(t);
+  if (!io::copy(header.begin(), header.end(), *fos))
+    return nullptr;
+  return streams_.emplace(t.name(), std::move(fos)).first->second.get();
+}
+
+bool bro::write(io::file_output_stream& os) {
+  auto result = io::copy(buffer_.begin(), buffer_.end(), os);
+  buffer_.clear();
+  return result;
 }
 
 } // namespace sink
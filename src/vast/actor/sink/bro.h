@@ -2,6 +2,7 @@
 #define VAST_ACTOR_SINK_BRO_H
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 #include "vast/filesystem.h"
@@ -27,14 +28,24 @@ public:
   /// @param p The output path.
   bro(path p);
 
-  bool process(event const& e);
+  bool process_batch(batch events);
+
+  void flush();
 
 private:
   using map_type
     = std::unordered_map<std::string, std::unique_ptr<io::file_output_stream>>;
 
+  // Retrieves the stream for events of a given type, creating it and writing
+  // the log header on first use.
+  io::file_output_stream* stream(type const& t);
+
+  // Writes the buffered lines into a stream.
+  bool write(io::file_output_stream& os);
+
   path dir_;
   map_type streams_;
+  std::string buffer_;
 };
 
 } // namespace sink
@@ -1,28 +1,150 @@
+#include <algorithm>
+#include <array>
 #include <iterator>
 #include <ostream>
 
 #include "vast/actor/sink/json.h"
-#include "vast/concept/convertible/vast/event.h"
-#include "vast/concept/convertible/to.h"
 #include "vast/concept/printable/print.h"
-#include "vast/concept/printable/vast/event.h"
+#include "vast/concept/printable/to_string.h"
+#include "vast/concept/printable/vast/address.h"
 #include "vast/concept/printable/vast/json.h"
+#include "vast/concept/printable/vast/pattern.h"
+#include "vast/concept/printable/vast/port.h"
+#include "vast/concept/printable/vast/subnet.h"
+#include "vast/concept/printable/vast/type.h"
 #include "vast/util/assert.h"
+#include "vast/util/string.h"
 
 namespace vast {
 namespace sink {
 
+namespace {
+
+using iterator = std::back_insert_iterator<std::string>;
+using json_visitor = json_printer<policy::tree, 2>::print_visitor<iterator>;
+
+// Prints data exactly like the JSON tree printer prints its JSON conversion.
+struct data_printer {
+  data_printer(json_visitor& v) : v_{v} {
+  }
+
+  bool operator()(none) const {
+    return v_(nil);
+  }
+
+  bool operator()(bool b) const {
+    return v_(b);
+  }
+
+  template <typename T>
+  auto operator()(T x) const
+    -> std::enable_if_t<std::is_arithmetic<T>::value, bool> {
+    return v_(vast::json::number(x));
+  }
+
+  bool operator()(time::point p) const {
+    return v_(vast::json::number(p.time_since_epoch().count()));
+  }
+
+  bool operator()(time::duration d) const {
+    return v_(vast::json::number(d.count()));
+  }
+
+  bool operator()(std::string const& str) const {
+    return v_(str);
+  }
+
+  template <typename T>
+  auto operator()(T const& x) const
+    -> std::enable_if_t<std::is_same<T, pattern>::value
+                          || std::is_same<T, address>::value
+                          || std::is_same<T, subnet>::value
+                          || std::is_same<T, port>::value,
+                        bool> {
+    return v_(to_string(x));
+  }
+
+  template <typename T>
+  auto operator()(T const& xs) const
+    -> std::enable_if_t<std::is_same<T, vector>::value
+                          || std::is_same<T, set>::value
+                          || std::is_same<T, record>::value,
+                        bool> {
+    return v_.print_array(xs, [&](auto& x) { return visit(*this, x); });
+  }
+
+  bool operator()(table const& t) const {
+    return v_.print_array(t, [&](auto& p) {
+      std::array<data const*, 2> pair{{&p.first, &p.second}};
+      return v_.print_array(pair, [&](auto x) { return visit(*this, *x); });
+    });
+  }
+
+  json_visitor& v_;
+};
+
+} // namespace <anonymous>
+
 json::json(std::unique_ptr<std::ostream> out)
   : base<json>{"json-sink"}, out_{std::move(out)} {
   VAST_ASSERT(out_ != nullptr);
 }
 
-bool json::process(event const& e) {
-  auto j = to<vast::json>(e);
-  if (!j)
-    return false;
-  auto i = std::ostreambuf_iterator<std::ostream::char_type>{*out_};
-  return print(i, *j) && print(i, '\n');
+bool json::process_batch(batch events) {
+  // We print events directly into a buffer, with the same layout as printing
+  // their conversion into vast::json, but without building a JSON tree.
+  buffer_.clear();
+  auto out = std::back_inserter(buffer_);
+  // The event data sits two levels deep, within the "value" object.
+  json_visitor v{out, 2};
+  data_printer print_data{v};
+  std::vector<std::pair<std::string const*, data const*>> fields;
+  for (auto& e : events) {
+    auto i = signatures_.find(e.type());
+    if (i == signatures_.end()) {
+      std::string sig;
+      if (!printers::type<policy::signature>(sig, e.type()))
+        return false;
+      i = signatures_.emplace(e.type(), util::json_escape(sig)).first;
+    }
+    buffer_ += "{\n  \"id\": ";
+    if (!v(vast::json::number(e.id())))
+      return false;
+    buffer_ += ",\n  \"timestamp\": ";
+    if (!v(vast::json::number(e.timestamp().time_since_epoch().count())))
+      return false;
+    buffer_ += ",\n  \"value\": {\n    \"data\": ";
+    if (auto r = get<type::record>(e.type())) {
+      // Record fields appear by name in lexicographical order, as in a JSON
+      // object. Of multiple fields with the same name, the last one wins.
+      auto d = get<record>(e);
+      VAST_ASSERT(d);
+      fields.clear();
+      type::record::each type_range{*r};
+      record::each data_range{*d};
+      auto t = type_range.begin();
+      auto x = data_range.begin();
+      for (; t != type_range.end(); ++t, ++x)
+        fields.emplace_back(&t->trace.back()->name, &x->data());
+      std::stable_sort(fields.begin(), fields.end(), [](auto& l, auto& r) {
+        return *l.first < *r.first;
+      });
+      auto last = std::unique(fields.rbegin(), fields.rend(),
+                              [](auto& l, auto& r) {
+                                return *l.first == *r.first;
+                              });
+      fields.erase(fields.begin(), last.base());
+      auto print_field = [&](auto x) { return visit(print_data, *x); };
+      if (!v.print_object(fields, print_field))
+        return false;
+    } else if (!visit(print_data, e)) {
+      return false;
+    }
+    buffer_ += ",\n    \"type\": ";
+    buffer_ += i->second;
+    buffer_ += "\n  }\n}\n";
+  }
+  return static_cast<bool>(out_->write(buffer_.data(), buffer_.size()));
 }
 
 void json::flush() {
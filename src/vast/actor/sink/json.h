@@ -3,7 +3,10 @@
 
 #include <iosfwd>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
+#include "vast/type.h"
 #include "vast/actor/sink/base.h"
 
 namespace vast {
@@ -16,12 +19,14 @@ public:
   /// @param out The output stream.
   json(std::unique_ptr<std::ostream> out);
 
-  bool process(event const& e);
+  bool process_batch(batch events);
 
   void flush();
 
 private:
   std::unique_ptr<std::ostream> out_;
+  std::string buffer_;
+  std::unordered_map<type, std::string> signatures_;
 };
 
 } // namespace sink
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+#include "vast/chunk.h"
+#include "vast/event.h"
+#include "vast/schema.h"
+#include "vast/actor/sink/native.h"
+#include "vast/concept/serializable/io.h"
+#include "vast/concept/serializable/vast/chunk.h"
+#include "vast/concept/serializable/vast/schema.h"
+#include "vast/detail/native_format.h"
+#include "vast/util/assert.h"
+
+namespace vast {
+namespace sink {
+
+constexpr size_t native::max_chunk_bytes;
+
+native::native(std::unique_ptr<std::ostream> out, io::compression method,
+               size_t events)
+  : base<native>{"native-sink"},
+    out_{std::move(out)},
+    method_{method},
+    chunk_size_{events} {
+  VAST_ASSERT(out_ != nullptr);
+  VAST_ASSERT(chunk_size_ > 0);
+  using namespace detail::native_format;
+  uint8_t v[sizeof(version)];
+  encode(version, v);
+  out_->write(magic, sizeof(magic));
+  out_->write(reinterpret_cast<char const*>(v), sizeof(v));
+}
+
+bool native::process_batch(batch events) {
+  // Chunks span multiple messages, because the exporter may deliver only a
+  // few events at a time.
+  for (auto& e : events) {
+    pending_.push_back(e);
+    pending_bytes_ += footprint(e);
+    auto full = pending_.size() == chunk_size_
+                || pending_bytes_ >= max_chunk_bytes;
+    if (full && !write_chunk())
+      return false;
+  }
+  return true;
+}
+
+void native::flush() {
+  if (write_chunk())
+    out_->flush();
+}
+
+bool native::write_chunk() {
+  using namespace detail::native_format;
+  if (pending_.empty())
+    return true;
+  // Announce the types we have not written yet ahead of the chunk.
+  schema fresh;
+  for (auto& e : pending_)
+    if (types_.insert(e.type()).second) {
+      auto added = fresh.add(e.type());
+      if (!added) {
+        VAST_ERROR(this, "failed to add type:", added.error());
+        return false;
+      }
+    }
+  if (!fresh.empty()) {
+    save(buffer_, fresh);
+    if (!write_frame(schema_frame))
+      return false;
+  }
+  // Chunks require increasing event IDs, which events from multiple
+  // partitions may lack.
+  auto by_id = [](auto& x, auto& y) { return x.id() < y.id(); };
+  if (!std::is_sorted(pending_.begin(), pending_.end(), by_id))
+    std::stable_sort(pending_.begin(), pending_.end(), by_id);
+  chunk chk{method_};
+  {
+    chunk::writer writer{chk};
+    for (auto& e : pending_)
+      if (!writer.write(e)) {
+        VAST_ERROR(this, "failed to write event into chunk");
+        return false;
+      }
+  }
+  pending_.clear();
+  pending_bytes_ = 0;
+  save(buffer_, chk);
+  return write_frame(chunk_frame);
+}
+
+bool native::write_frame(uint8_t kind) {
+  using namespace detail::native_format;
+  if (buffer_.size() > std::numeric_limits<uint32_t>::max()) {
+    VAST_ERROR(this, "cannot write frame of", buffer_.size(), "bytes");
+    buffer_.clear();
+    return false;
+  }
+  uint8_t header[frame_header_size];
+  header[0] = kind;
+  encode(static_cast<uint32_t>(buffer_.size()), header + 1);
+  out_->write(reinterpret_cast<char const*>(header), sizeof(header));
+  out_->write(reinterpret_cast<char const*>(buffer_.data()), buffer_.size());
+  buffer_.clear();
+  if (!*out_) {
+    VAST_ERROR(this, "failed to write frame");
+    return false;
+  }
+  return true;
+}
+
+} // namespace sink
+} // namespace vast
@@ -0,0 +1,58 @@
+#ifndef VAST_ACTOR_SINK_NATIVE_H
+#define VAST_ACTOR_SINK_NATIVE_H
+
+#include <iosfwd>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "vast/type.h"
+#include "vast/io/compression.h"
+#include "vast/actor/sink/base.h"
+
+namespace vast {
+namespace sink {
+
+/// A sink writing events in VAST's native binary format, which the *native*
+/// source reads back without any parsing. Events accumulate across messages
+/// into compressed ::chunk instances of a fixed number of events, and a flush
+/// writes out the remainder.
+class native : public base<native> {
+public:
+  /// The in-memory size of pending events at which the sink writes a chunk
+  /// regardless of the number of events. This keeps frames well below their
+  /// 4 GiB limit even for events with large payloads.
+  static constexpr size_t max_chunk_bytes = 256 << 20;
+
+  /// Spawns a native sink.
+  /// @param out The output stream.
+  /// @param method The compression method for chunks.
+  /// @param events The maximum number of events per chunk.
+  native(std::unique_ptr<std::ostream> out,
+         io::compression method = io::lz4, size_t events = 65536);
+
+  bool process_batch(batch events);
+
+  void flush();
+
+private:
+  // Writes the pending events as one chunk, preceded by a schema frame for
+  // types not seen before.
+  bool write_chunk();
+
+  // Writes a frame with a serialized payload.
+  bool write_frame(uint8_t kind);
+
+  std::unique_ptr<std::ostream> out_;
+  io::compression method_;
+  size_t chunk_size_;
+  std::unordered_set<type> types_;
+  std::vector<event> pending_;
+  size_t pending_bytes_ = 0;
+  std::vector<uint8_t> buffer_;
+};
+
+} // namespace sink
+} // namespace vast
+
+#endif
@@ -1,3 +1,12 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <pcap.h>
+
 #include "vast/actor/sink/pcap.h"
 #include "vast/detail/pcap_packet_type.h"
 #include "vast/concept/printable/vast/filesystem.h"
@@ -5,87 +14,212 @@
 namespace vast {
 namespace sink {
 
-pcap::pcap(schema sch, path trace, size_t flush)
+namespace {
+
+// The link type of raw IP packets in trace files. It differs from the value
+// of DLT_RAW, which libpcap translates when writing a trace.
+constexpr uint32_t linktype_raw = 101;
+
+#ifdef PCAP_TSTAMP_PRECISION_NANO
+constexpr uint32_t magic = 0xa1b23c4d;
+constexpr uint64_t ns_per_tick = 1;
+#else
+constexpr uint32_t magic = 0xa1b2c3d4;
+constexpr uint64_t ns_per_tick = 1000;
+#endif
+
+template <typename T>
+void append(std::vector<uint8_t>& buf, T x) {
+  auto p = reinterpret_cast<uint8_t const*>(&x);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+bool write_all(int fd, std::vector<uint8_t> const& buf) {
+  auto data = buf.data();
+  auto size = buf.size();
+  while (size > 0) {
+    auto n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+} // namespace <anonymous>
+
+pcap::pcap(schema sch, path trace, size_t flush, size_t window)
   : base<pcap>{"pcap-sink"},
     schema_{std::move(sch)},
     trace_{std::move(trace)},
     packet_type_{detail::pcap_packet_type},
-    flush_{flush} {
+    flush_{std::max(flush, size_t{1})},
+    window_{window} {
 }
 
 pcap::~pcap() {
-  if (pcap_dumper_)
-    ::pcap_dump_close(pcap_dumper_);
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+  if (fd_ > 1)
+    ::close(fd_);
+}
 
-  if (pcap_)
-    ::pcap_close(pcap_);
+void pcap::on_exit() {
+  base<pcap>::on_exit();
+  if (fd_ == -1)
+    return;
+  // Write the packets we held back, in timestamp order.
+  auto later = [](auto& x, auto& y) { return x.timestamp > y.timestamp; };
+  while (!pending_.empty()) {
+    std::pop_heap(pending_.begin(), pending_.end(), later);
+    write(pending_.back());
+    pending_.pop_back();
+    if (block_packets_ >= flush_ && !hand_over())
+      break;
+  }
+  hand_over();
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  if (fd_ > 1)
+    ::close(fd_);
+  fd_ = -1;
+  if (reordered_ > 0)
+    VAST_WARN(this, "wrote", reordered_, "packets out of order beyond a window"
+              " of", window_, "packets");
+  VAST_VERBOSE(this, "wrote", total_packets_, "packets to", trace_);
 }
 
 bool pcap::process(event const& e) {
-  if (!pcap_) {
-    if (trace_ != "-" && !exists(trace_)) {
-      VAST_ERROR(this, "cannot locate file:", trace_);
-      quit(exit::error);
-      return false;
-    }
-#ifdef PCAP_TSTAMP_PRECISION_NANO
-    pcap_ = ::pcap_open_dead_with_tstamp_precision(DLT_RAW, 65535,
-                                                   PCAP_TSTAMP_PRECISION_NANO);
-#else
-    pcap_ = ::pcap_open_dead(DLT_RAW, 65535);
-#endif
-    if (!pcap_) {
-      VAST_ERROR(this, "failed to open pcap handle");
-      quit(exit::error);
-      return false;
-    }
-    pcap_dumper_ = ::pcap_dump_open(pcap_, trace_.str().c_str());
-    if (!pcap_dumper_) {
-      VAST_ERROR(this, "failed to open pcap dumper for", trace_);
-      quit(exit::error);
-      return false;
-    }
-    if (auto t = schema_.find_type("vast::packet")) {
-      if (congruent(packet_type_, *t)) {
-        VAST_VERBOSE(this, "prefers type in schema over default type");
-        packet_type_ = *t;
-      } else {
-        VAST_WARN(this, "ignores incongruent schema type:", t->name());
-      }
-    }
-  }
+  if (fd_ == -1 && !open())
+    return false;
   if (e.type() != packet_type_) {
     VAST_ERROR(this, "cannot process non-packet event:", e.type());
-    quit(exit::error);
     return false;
   }
   auto r = get<record>(e);
-  assert(r);
-  assert(r->size() == 2);
+  VAST_ASSERT(r);
+  VAST_ASSERT(r->size() == 2);
   auto data = get<std::string>((*r)[1]);
-  assert(data);
-  // Make PCAP header.
-  ::pcap_pkthdr header;
+  VAST_ASSERT(data);
   auto ns = e.timestamp().time_since_epoch().count();
-  header.ts.tv_sec = ns / 1000000000;
-#ifdef PCAP_TSTAMP_PRECISION_NANO
-  header.ts.tv_usec = ns % 1000000000;
-#else
-  ns /= 1000;
-  header.ts.tv_usec = ns % 1000000;
-#endif
-  header.caplen = data->size();
-  header.len = data->size();
-  // Dump packet.
-  ::pcap_dump(reinterpret_cast<uint8_t*>(pcap_dumper_), &header,
-              reinterpret_cast<uint8_t const*>(data->c_str()));
-  if (++total_packets_ % flush_ == 0 && ::pcap_dump_flush(pcap_dumper_) == -1) {
-    VAST_ERROR(this, "failed to flush at packet", total_packets_);
-    quit(exit::error);
+  auto later = [](auto& x, auto& y) { return x.timestamp > y.timestamp; };
+  pending_.push_back({static_cast<uint64_t>(ns), *data});
+  std::push_heap(pending_.begin(), pending_.end(), later);
+  if (pending_.size() > window_) {
+    std::pop_heap(pending_.begin(), pending_.end(), later);
+    write(pending_.back());
+    pending_.pop_back();
+  }
+  return block_packets_ < flush_ || hand_over();
+}
+
+void pcap::flush() {
+  if (fd_ != -1)
+    hand_over();
+}
+
+bool pcap::open() {
+  if (trace_ == "-") {
+    fd_ = 1;
+  } else {
+    fd_ = ::open(trace_.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1) {
+      VAST_ERROR(this, "failed to open", trace_ << ':', std::strerror(errno));
+      return false;
+    }
+  }
+  if (auto t = schema_.find_type("vast::packet")) {
+    if (congruent(packet_type_, *t)) {
+      VAST_VERBOSE(this, "prefers type in schema over default type");
+      packet_type_ = *t;
+    } else {
+      VAST_WARN(this, "ignores incongruent schema type:", t->name());
+    }
+  }
+  // The global header of the trace.
+  append(block_, magic);
+  append(block_, uint16_t{2});
+  append(block_, uint16_t{4});
+  append(block_, int32_t{0});
+  append(block_, uint32_t{0});
+  append(block_, uint32_t{65535});
+  append(block_, linktype_raw);
+  thread_ = std::thread{[=] { run(); }};
+  return true;
+}
+
+void pcap::write(packet const& p) {
+  if (p.timestamp < last_timestamp_)
+    ++reordered_;
+  else
+    last_timestamp_ = p.timestamp;
+  auto size = static_cast<uint32_t>(p.data.size());
+  append(block_, static_cast<uint32_t>(p.timestamp / 1000000000));
+  append(block_, static_cast<uint32_t>(p.timestamp % 1000000000 / ns_per_tick));
+  append(block_, size);
+  append(block_, size);
+  block_.insert(block_.end(), p.data.begin(), p.data.end());
+  ++block_packets_;
+  ++total_packets_;
+}
+
+bool pcap::hand_over() {
+  if (block_.empty())
+    return true;
+  std::unique_lock<std::mutex> lock{mutex_};
+  cv_.wait(lock, [&] { return failed_ || full_.size() < max_blocks_queued; });
+  if (failed_) {
+    VAST_ERROR(this, "failed to write to", trace_);
     return false;
   }
+  full_.push_back(std::move(block_));
+  block_ = {};
+  if (!empty_.empty()) {
+    block_ = std::move(empty_.back());
+    empty_.pop_back();
+  }
+  lock.unlock();
+  cv_.notify_all();
+  block_packets_ = 0;
   return true;
 }
 
+void pcap::run() {
+  for (;;) {
+    std::vector<uint8_t> block;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [&] { return stop_ || !full_.empty(); });
+      if (full_.empty())
+        return;
+      block = std::move(full_.front());
+      full_.pop_front();
+    }
+    auto ok = write_all(fd_, block);
+    block.clear();
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (!ok)
+        failed_ = true;
+      empty_.push_back(std::move(block));
+    }
+    cv_.notify_all();
+  }
+}
+
 } // namespace sink
 } // namespace vast
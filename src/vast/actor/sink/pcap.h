@@ -1,7 +1,13 @@
 #ifndef VAST_ACTOR_SINK_PCAP_H
 #define VAST_ACTOR_SINK_PCAP_H
 
-#include <pcap.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "vast/filesystem.h"
 #include "vast/schema.h"
 #include "vast/type.h"
@@ -10,27 +16,72 @@
 namespace vast {
 namespace sink {
 
-/// A file source that reads PCAP traces.
+/// A sink that writes packet events into a PCAP trace.
+///
+/// The sink holds back a window of packets and always writes the one with
+/// the smallest timestamp, so that packets from different chunks end up in
+/// timestamp order. It serializes packets into large blocks, which a
+/// background thread writes to the trace while the sink processes the next
+/// packets.
 class pcap : public base<pcap> {
 public:
-  /// Constructs a file source.
+  /// Constructs a PCAP sink.
   /// @param sch The schema containing the packet type.
   /// @param trace The name of the trace file to construct.
   /// @param flush Number of packets after which to flush to disk.
-  pcap(schema sch, path trace, size_t flush = 10000);
+  /// @param window Number of packets to hold back for ordering them by
+  ///               timestamp.
+  pcap(schema sch, path trace, size_t flush = 10000, size_t window = 100000);
 
   ~pcap();
 
+  void on_exit() override;
+
   bool process(event const& e);
 
+  void flush();
+
 private:
+  struct packet {
+    uint64_t timestamp;
+    std::string data;
+  };
+
+  // The number of blocks the sink may queue for the writer thread.
+  static constexpr size_t max_blocks_queued = 2;
+
+  // Opens the trace and starts the writer thread.
+  bool open();
+
+  // Appends a packet to the current block.
+  void write(packet const& p);
+
+  // Hands the current block to the writer thread.
+  bool hand_over();
+
+  // The loop of the writer thread.
+  void run();
+
   schema schema_;
   path trace_;
   type packet_type_;
   size_t flush_;
+  size_t window_;
+  std::vector<packet> pending_;
+  uint64_t last_timestamp_ = 0;
+  size_t reordered_ = 0;
   size_t total_packets_ = 0;
-  pcap_t* pcap_ = nullptr;
-  pcap_dumper_t* pcap_dumper_ = nullptr;
+  int fd_ = -1;
+  std::vector<uint8_t> block_;
+  size_t block_packets_ = 0;
+  // Shared with the writer thread.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::vector<uint8_t>> full_;
+  std::vector<std::vector<uint8_t>> empty_;
+  bool stop_ = false;
+  bool failed_ = false;
+  std::thread thread_;
 };
 
 } // namespace sink
@@ -5,9 +5,11 @@
 #include <caf/detail/scope_guard.hpp>
 
 #include "vast/config.h"
+#include "vast/actor/sink/arrow.h"
 #include "vast/actor/sink/ascii.h"
 #include "vast/actor/sink/bro.h"
 #include "vast/actor/sink/json.h"
+#include "vast/actor/sink/native.h"
 #include "vast/concept/parseable/vast/detail/to_schema.h"
 #include "vast/concept/printable/vast/schema.h"
 #include "vast/util/fdostream.h"
@@ -48,11 +50,11 @@ trial<caf::actor> spawn(message const& params) {
   actor snk;
   auto guard
     = caf::detail::make_scope_guard([&] { anon_send_exit(snk, exit::error); });
-  // The "pcap" and "bro" sink manually handle file output. All other
-  // sources are file-based and we setup their input stream here.
+  // The "pcap", "bro", and "arrow" sinks manually handle file output. All
+  // other sinks are file-based and we setup their output stream here.
   auto& format = params.get_as<std::string>(0);
   std::unique_ptr<std::ostream> out;
-  if (!(format == "pcap" || format == "bro")) {
+  if (!(format == "pcap" || format == "bro" || format == "arrow")) {
     if (r.opts.count("uds") > 0) {
       if (output == "-")
         return error{"cannot use stdout as UNIX domain socket"};
@@ -72,19 +74,45 @@ trial<caf::actor> spawn(message const& params) {
     return error{"not compiled with pcap support"};
 #else
     auto flush = 10000u;
+    auto window = 100000u;
     r = r.remainder.extract_opts({
-      {"flush,f", "flush to disk after this many packets", flush}
+      {"flush,f", "flush to disk after this many packets", flush},
+      {"window,o", "packets to hold back for ordering by timestamp", window}
     });
     if (!r.error.empty())
       return error{std::move(r.error)};
-    snk = caf::spawn<sink::pcap, priority_aware>(sch, output, flush);
+    snk = caf::spawn<sink::pcap, priority_aware>(sch, output, flush, window);
 #endif
   } else if (format == "bro") {
     snk = caf::spawn<sink::bro>(output);
+  } else if (format == "arrow") {
+    snk = caf::spawn<sink::arrow>(output);
   } else if (format == "ascii") {
     snk = caf::spawn<sink::ascii>(std::move(out));
   } else if (format == "json") {
     snk = caf::spawn<sink::json>(std::move(out));
+  } else if (format == "native") {
+    auto comp = "lz4"s;
+    r = r.remainder.extract_opts({
+      {"compression,c", "compression method for chunks", comp}
+    });
+    if (!r.error.empty())
+      return error{std::move(r.error)};
+    io::compression method;
+    if (comp == "null") {
+      method = io::null;
+    } else if (comp == "lz4") {
+      method = io::lz4;
+    } else if (comp == "snappy") {
+#ifdef VAST_HAVE_SNAPPY
+      method = io::snappy;
+#else
+      return error{"not compiled with snappy support"};
+#endif
+    } else {
+      return error{"unknown compression method: ", comp};
+    }
+    snk = caf::spawn<sink::native>(std::move(out), method);
   } else {
     return error{"invalid export format: ", format};
   }
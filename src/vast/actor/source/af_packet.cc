@@ -0,0 +1,165 @@
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "vast/event.h"
+#include "vast/actor/source/af_packet.h"
+
+namespace vast {
+namespace source {
+
+af_packet::af_packet(std::string interface, uint64_t cutoff, size_t max_flows,
+                     size_t max_age, size_t expire_interval, uint16_t fanout,
+                     size_t block_size, size_t blocks)
+  : base<af_packet>{"af_packet-source"},
+    interface_{std::move(interface)},
+    decoder_{cutoff, max_flows, max_age, expire_interval},
+    fanout_{fanout},
+    block_size_{block_size},
+    blocks_{blocks} {
+}
+
+af_packet::~af_packet() {
+  if (ring_)
+    ::munmap(ring_, block_size_ * blocks_);
+  if (fd_ != -1)
+    ::close(fd_);
+}
+
+schema af_packet::sniff() {
+  schema sch;
+  sch.add(decoder_.packet_type);
+  return sch;
+}
+
+void af_packet::set(schema const& sch) {
+  auto t = sch.find_type("vast::packet");
+  if (!t) {
+    VAST_ERROR(this, "did not find type vast::packet in given schema");
+    return;
+  }
+  if (!congruent(decoder_.packet_type, *t)) {
+    VAST_WARN(this, "ignores incongruent schema type:", t->name());
+    return;
+  }
+  VAST_VERBOSE(this, "prefers type in schema over default type");
+  decoder_.packet_type = *t;
+}
+
+result<event> af_packet::extract() {
+  if (fd_ == -1) {
+    auto t = open();
+    if (!t) {
+      // Without the capability or interface, the import must not look
+      // successful.
+      fail();
+      return t.error();
+    }
+  }
+  // Walk the packets of the current block, fetching a new block from the
+  // kernel once we have processed all of them.
+  while (remaining_ == 0)
+    if (!next_block())
+      return {}; // Waiting for the next block timed out.
+  auto hdr = packet_;
+  --remaining_;
+  if (remaining_ > 0)
+    packet_ = reinterpret_cast<tpacket3_hdr*>(
+      reinterpret_cast<uint8_t*>(packet_) + packet_->tp_next_offset);
+  consumed(hdr->tp_snaplen);
+  auto data = reinterpret_cast<uint8_t const*>(hdr) + hdr->tp_mac;
+  auto timestamp = std::chrono::seconds(hdr->tp_sec)
+                   + std::chrono::nanoseconds(hdr->tp_nsec);
+  return decoder_.decode(data, hdr->tp_snaplen, hdr->tp_len,
+                         time::point{timestamp});
+}
+
+trial<void> af_packet::open() {
+  auto fail = [&](char const* what) {
+    auto err = error{what, " on ", interface_, ": ", std::strerror(errno)};
+    if (fd_ != -1)
+      ::close(fd_);
+    fd_ = -1;
+    return err;
+  };
+  fd_ = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+  if (fd_ == -1)
+    return fail("failed to create packet socket");
+  int version = TPACKET_V3;
+  if (::setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version,
+                   sizeof(version)) == -1)
+    return fail("failed to select TPACKET_V3");
+  tpacket_req3 req;
+  std::memset(&req, 0, sizeof(req));
+  req.tp_block_size = block_size_;
+  req.tp_block_nr = blocks_;
+  req.tp_frame_size = TPACKET_ALIGNMENT << 7;
+  req.tp_frame_nr = (block_size_ * blocks_) / req.tp_frame_size;
+  req.tp_retire_blk_tov = 60; // Hand over partial blocks after 60 ms.
+  req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+  if (::setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) == -1)
+    return fail("failed to set up receive ring");
+  auto ring = ::mmap(nullptr, block_size_ * blocks_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd_, 0);
+  if (ring == MAP_FAILED)
+    return fail("failed to map receive ring");
+  ring_ = static_cast<uint8_t*>(ring);
+  sockaddr_ll addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sll_family = AF_PACKET;
+  addr.sll_protocol = htons(ETH_P_ALL);
+  addr.sll_ifindex = ::if_nametoindex(interface_.c_str());
+  if (addr.sll_ifindex == 0)
+    return fail("failed to find interface");
+  if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+    return fail("failed to bind packet socket");
+  if (fanout_ > 0) {
+    // Hashing keeps all packets of a flow at the same source.
+    int arg = fanout_ | (PACKET_FANOUT_HASH << 16);
+    if (::setsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg)) == -1)
+      return fail("failed to join fanout group");
+    VAST_VERBOSE(this, "joined fanout group", fanout_);
+  }
+  VAST_INFO(this, "listens on interface", interface_, "with",
+            blocks_, "blocks of", block_size_, "bytes");
+  return nothing;
+}
+
+bool af_packet::next_block() {
+  if (block_) {
+    block_->hdr.bh1.block_status = TP_STATUS_KERNEL;
+    block_ = nullptr;
+    current_ = (current_ + 1) % blocks_;
+  }
+  auto b = reinterpret_cast<tpacket_block_desc*>(ring_ + current_ * block_size_);
+  if (!(b->hdr.bh1.block_status & TP_STATUS_USER)) {
+    pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN | POLLERR;
+    pfd.revents = 0;
+    // Do not wait longer than the latency budget of the current batch
+    // allows, so that a quiet interface does not delay the events we have.
+    auto timeout = time::duration_cast<std::chrono::milliseconds>(
+      std::min(remaining_latency(), time::extent{std::chrono::seconds(1)}));
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0)
+      return false;
+    if (!(b->hdr.bh1.block_status & TP_STATUS_USER))
+      return false;
+  }
+  block_ = b;
+  remaining_ = b->hdr.bh1.num_pkts;
+  packet_ = reinterpret_cast<tpacket3_hdr*>(
+    reinterpret_cast<uint8_t*>(b) + b->hdr.bh1.offset_to_first_pkt);
+  return true;
+}
+
+} // namespace source
+} // namespace vast
@@ -0,0 +1,76 @@
+#ifndef VAST_ACTOR_SOURCE_AF_PACKET_H
+#define VAST_ACTOR_SOURCE_AF_PACKET_H
+
+#include <string>
+
+#include "vast/schema.h"
+#include "vast/trial.h"
+#include "vast/actor/source/base.h"
+#include "vast/actor/source/packet.h"
+
+struct tpacket_block_desc;
+struct tpacket3_hdr;
+
+namespace vast {
+namespace source {
+
+/// A source that captures packets from a Linux network interface through a
+/// memory-mapped `AF_PACKET` ring buffer (TPACKET_V3). The kernel fills the
+/// ring with blocks of packets, which the source processes one block at a
+/// time without a system call per packet.
+///
+/// Multiple sources capturing from the same interface with the same non-zero
+/// fanout group share the traffic. The kernel assigns packets to sources by
+/// flow hash, so that each flow ends up at a single source.
+class af_packet : public base<af_packet> {
+public:
+  /// Constructs an `AF_PACKET` source.
+  /// @param interface The name of the interface to capture from.
+  /// @param cutoff The number of bytes to keep per flow.
+  /// @param max_flows The maximum number of flows to keep state for.
+  /// @param max_age The number of seconds to wait since the last seen packet
+  ///                before evicting the corresponding flow.
+  /// @param expire_interval The number of seconds between successive expire
+  ///                        passes over the flow table.
+  /// @param fanout The fanout group to join, or 0 to capture all traffic.
+  /// @param block_size The size of a ring block in bytes, which must be a
+  ///                   multiple of the page size.
+  /// @param blocks The number of blocks in the ring.
+  af_packet(std::string interface, uint64_t cutoff = -1,
+            size_t max_flows = 100000, size_t max_age = 60,
+            size_t expire_interval = 10, uint16_t fanout = 0,
+            size_t block_size = 1 << 22, size_t blocks = 64);
+
+  ~af_packet();
+
+  schema sniff();
+
+  void set(schema const& sch);
+
+  result<event> extract();
+
+private:
+  // Creates the socket, maps the ring, and joins the fanout group.
+  trial<void> open();
+
+  // Hands the current block back to the kernel and waits for the next one.
+  // Returns false if no block became available within the poll timeout.
+  bool next_block();
+
+  std::string interface_;
+  packet_decoder decoder_;
+  uint16_t fanout_;
+  size_t block_size_;
+  size_t blocks_;
+  int fd_ = -1;
+  uint8_t* ring_ = nullptr;
+  size_t current_ = 0;
+  tpacket_block_desc* block_ = nullptr;
+  tpacket3_hdr* packet_ = nullptr;
+  uint32_t remaining_ = 0;
+};
+
+} // namespace source
+} // namespace vast
+
+#endif
@@ -1,19 +1,32 @@
 #ifndef VAST_ACTOR_SOURCE_BASE_H
 #define VAST_ACTOR_SOURCE_BASE_H
 
+#include <algorithm>
+
 #include <caf/all.hpp>
 
 #include "vast/event.h"
 #include "vast/result.h"
+#include "vast/time.h"
 #include "vast/actor/actor.h"
 #include "vast/concept/printable/vast/error.h"
 #include "vast/util/assert.h"
+#include "vast/util/math.h"
 
 namespace vast {
 namespace source {
 
 /// The base class for data sources which synchronously extract events
 /// one-by-one.
+///
+/// A source ships a batch when it reaches the configured number of events,
+/// when the input consumed for the batch exceeds a byte budget, or when
+/// filling the batch takes longer than a latency budget. From completed
+/// batches, the source estimates the input size per event and the event rate
+/// to size the next batch, such that it meets both budgets on average.
+///
+/// When a sink grants credit, the source also never ships more events than
+/// its credit allows, and pauses when the credit runs out.
 template <typename Derived>
 class base : public flow_controlled_actor {
 public:
@@ -56,10 +69,25 @@ public:
         if (!done())
           send(this, run_atom::value);
       },
+      [=](credit_atom, uint64_t events, uint64_t bytes) {
+        auto starved = !has_credit();
+        add_credit(events, bytes);
+        // Resume if we have stopped for lack of credit.
+        if (starved && has_credit() && !done() && !overloaded())
+          send(this, run_atom::value);
+      },
       [=](batch_atom, uint64_t batch_size) {
         VAST_DEBUG(this, "sets batch size to", batch_size);
         batch_size_ = batch_size;
       },
+      [=](batch_atom, uint64_t batch_size, uint64_t batch_bytes,
+          time::duration batch_latency) {
+        VAST_DEBUG(this, "sets batch size to", batch_size, "events,",
+                   batch_bytes, "bytes, and", batch_latency);
+        batch_size_ = batch_size;
+        batch_bytes_ = batch_bytes;
+        batch_latency_ = time::nanoseconds{batch_latency.count()};
+      },
       [=](get_atom, schema_atom) {
         return static_cast<Derived*>(this)->sniff();
       },
@@ -84,7 +112,15 @@ public:
           this->quit(exit::error);
           return;
         }
-        while (events_.size() < batch_size_ && !done()) {
+        if (!has_credit()) {
+          VAST_DEBUG(this, "waits for credit");
+          return;
+        }
+        auto start = batch_start_ = time::snapshot();
+        auto start_bytes = bytes_;
+        auto max_events = batch_size();
+        auto i = uint64_t{0};
+        while (events_.size() < max_events && !done()) {
           result<event> r = static_cast<Derived*>(this)->extract();
           if (r) {
             events_.push_back(std::move(*r));
@@ -93,17 +129,24 @@ public:
             done(true);
             break;
           }
+          if (batch_bytes_ > 0 && bytes_ - start_bytes >= batch_bytes_)
+            break;
+          // Querying the clock for every event would be too expensive. But
+          // when the source returns no event, it may have waited for input,
+          // so we check the clock right away.
+          if (batch_latency_ > time::extent::zero() && (!r || ++i % 64 == 0)
+              && time::snapshot() - start >= batch_latency_)
+            break;
         }
         if (!events_.empty()) {
-          VAST_VERBOSE(this, "produced", events_.size(), "events");
-          if (accountant_ != invalid_actor)
-            send(accountant_, uint64_t{events_.size()}, time::snapshot());
-          send(sinks_[next_sink_++ % sinks_.size()], std::move(events_));
+          adapt(events_.size(), bytes_ - start_bytes,
+                time::snapshot() - start);
+          ship(std::move(events_), bytes_ - start_bytes);
           events_ = {};
         }
         if (done())
-          send_exit(*this, exit::done);
-        else if (!overloaded())
+          send_exit(*this, failed_ ? exit::error : exit::done);
+        else if (!overloaded() && has_credit())
           this->send(this, this->current_message());
       },
       catch_unexpected(),
@@ -119,12 +162,110 @@ protected:
     done_ = flag;
   }
 
+  /// Checks whether the source stopped because its input failed.
+  bool failed() const {
+    return failed_;
+  }
+
+  /// Stops extracting events because the input failed. The source still
+  /// ships the events extracted so far, but then terminates with an error.
+  void fail() {
+    done_ = true;
+    failed_ = true;
+  }
+
+  /// Checks whether the source has at least one sink to ship events to.
+  bool has_sinks() const {
+    return !sinks_.empty();
+  }
+
+  /// Retrieves the number of events the source should produce per batch.
+  /// This number never exceeds the configured batch size and the available
+  /// credit, but may be lower to meet the byte and latency budgets of a
+  /// batch.
+  uint64_t batch_size() const {
+    auto n = std::min(batch_size_, available_credit());
+    if (batch_bytes_ > 0 && bytes_per_event_ > 0)
+      n = std::min(n, static_cast<uint64_t>(batch_bytes_ / bytes_per_event_));
+    if (batch_latency_ > time::extent::zero() && events_per_second_ > 0) {
+      auto secs = time::duration_cast<time::double_seconds>(batch_latency_);
+      n = std::min(n, static_cast<uint64_t>(events_per_second_ * secs.count()));
+    }
+    return std::max(n, uint64_t{1});
+  }
+
+  /// Retrieves the time left until the current batch exceeds its latency
+  /// budget. Sources which block while waiting for input should not wait
+  /// longer than this.
+  /// @returns The remaining time of the latency budget, or
+  ///          `time::extent::max()` if batches have no latency budget.
+  time::extent remaining_latency() const {
+    if (batch_latency_ <= time::extent::zero())
+      return time::extent::max();
+    auto elapsed = time::snapshot() - batch_start_;
+    if (elapsed >= batch_latency_)
+      return time::extent::zero();
+    return batch_latency_ - elapsed;
+  }
+
+  /// Accounts for input consumed while extracting events. Sources which
+  /// report their input enable the byte budget of batches.
+  /// @param bytes The number of input bytes consumed.
+  void consumed(uint64_t bytes) {
+    bytes_ += bytes;
+  }
+
+  /// Updates the estimates which determine ::batch_size with the statistics
+  /// of a completed batch.
+  /// @param events The number of events in the batch.
+  /// @param bytes The number of input bytes consumed for the batch.
+  /// @param elapsed The time it took to produce the batch.
+  void adapt(uint64_t events, uint64_t bytes, time::extent elapsed) {
+    if (events == 0)
+      return;
+    if (bytes > 0)
+      util::ewma(bytes_per_event_, static_cast<double>(bytes) / events);
+    auto secs = time::duration_cast<time::double_seconds>(elapsed).count();
+    if (secs > 0)
+      util::ewma(events_per_second_, events / secs);
+  }
+
+  /// Ships a batch of events to the next sink in round-robin fashion.
+  /// @param events The batch to ship.
+  /// @param bytes The number of input bytes consumed for *events*.
+  /// @param reserved Whether the source has consumed the credit for *events*
+  ///                 already, e.g., when it dispatched the work producing
+  ///                 them.
+  /// @pre `has_sinks()`
+  void ship(std::vector<event> events, uint64_t bytes, bool reserved = false) {
+    VAST_ASSERT(has_sinks());
+    VAST_VERBOSE(this, "produced", events.size(), "events");
+    if (accountant_ != caf::invalid_actor)
+      send(accountant_, uint64_t{events.size()}, time::snapshot());
+    auto& sink = sinks_[next_sink_++ % sinks_.size()];
+    if (credit_based()) {
+      if (!reserved)
+        consume_credit(events.size(), bytes);
+      // The sink granted the credit and accounts for the same bytes.
+      send(sink, std::move(events), bytes);
+    } else {
+      send(sink, std::move(events));
+    }
+  }
+
 private:
   bool done_ = false;
+  bool failed_ = false;
   caf::actor accountant_;
   std::vector<caf::actor> sinks_;
   size_t next_sink_ = 0;
   uint64_t batch_size_ = std::numeric_limits<uint16_t>::max();
+  uint64_t batch_bytes_ = 16 << 20;
+  time::extent batch_latency_ = time::seconds{1};
+  time::moment batch_start_;
+  uint64_t bytes_ = 0;
+  double bytes_per_event_ = 0;
+  double events_per_second_ = 0;
   std::vector<event> events_;
 };
 
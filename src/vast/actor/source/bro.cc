@@ -1,9 +1,14 @@
+#include <algorithm>
+#include <cstring>
+
 #include "vast/actor/source/bro.h"
 #include "vast/concept/parseable/vast/detail/bro_parser_factory.h"
 #include "vast/concept/printable/vast/type.h"
 #include "vast/util/assert.h"
 #include "vast/util/string.h"
 
+using namespace caf;
+
 namespace vast {
 namespace source {
 
@@ -61,8 +66,211 @@ trial<type> make_type(std::string const& bro_type) {
 
 } // namespace <anonymous>
 
-bro::bro(std::unique_ptr<io::input_stream> is)
-  : line_based<bro>{"bro-source", std::move(is)} {
+namespace detail {
+
+bro_line_parser::bro_line_parser(type t, std::string separator,
+                                 std::string set_separator,
+                                 std::string empty_field,
+                                 std::string unset_field, int timestamp_field)
+  : type_{std::move(t)},
+    separator_{std::move(separator)},
+    empty_field_{std::move(empty_field)},
+    unset_field_{std::move(unset_field)},
+    timestamp_field_{timestamp_field} {
+  auto rec = get<type::record>(type_);
+  VAST_ASSERT(rec);
+  size_ = rec->fields().size();
+  // Precompute for each field how to get from the record of the previous
+  // field to its own, so that parsing a line need not walk the type.
+  std::vector<type::record::field const*> prev;
+  for (auto& e : type::record::each{*rec}) {
+    field f;
+    f.name = e.trace.back()->name;
+    f.type = e.trace.back()->type;
+    f.parser = vast::detail::make_bro_parser<char const*>(f.type,
+                                                          set_separator);
+    // The common prefix of enclosing records with the previous field.
+    size_t common = 0;
+    while (common + 1 < e.trace.size() && common + 1 < prev.size()
+           && e.trace[common] == prev[common])
+      ++common;
+    f.depth = common + 1;
+    for (auto i = common; i + 1 < e.trace.size(); ++i)
+      f.open.push_back(get<type::record>(e.trace[i]->type)->fields().size());
+    prev.assign(e.trace.begin(), e.trace.end());
+    fields_.push_back(std::move(f));
+  }
+  split_.reserve(fields_.size());
+}
+
+trial<event> bro_line_parser::parse(util::string_ref line) {
+  split_.clear();
+  util::split(line.begin(), line.end(), separator_, split_);
+  if (split_.size() < fields_.size())
+    return error{"accessed field ", split_.size(), " out of bounds"};
+  record event_record;
+  event_record.reserve(size_);
+  records_.clear();
+  records_.push_back(&event_record);
+  optional<time::point> ts;
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    auto& f = fields_[i];
+    auto first = split_[i].first;
+    auto last = split_[i].second;
+    // Since every record reserves space for all its fields, pointers to
+    // nested records remain valid while we append to their parents.
+    records_.resize(f.depth);
+    for (auto n : f.open) {
+      auto r = records_.back();
+      r->push_back(record{});
+      records_.push_back(get<record>(r->back()));
+      records_.back()->reserve(n);
+    }
+    auto r = records_.back();
+    if (std::equal(unset_field_.begin(), unset_field_.end(), first, last)) {
+      r->emplace_back(nil);
+    } else if (std::equal(empty_field_.begin(), empty_field_.end(), first,
+                          last)) {
+      switch (which(f.type)) {
+        default:
+          return error{"got invalid empty field ", i, " \"", f.name,
+                       "\" of type ", f.type};
+        case type::tag::string:
+          r->emplace_back(std::string{});
+          break;
+        case type::tag::vector:
+          r->emplace_back(vector{});
+          break;
+        case type::tag::set:
+          r->emplace_back(vast::set{});
+          break;
+        case type::tag::table:
+          r->emplace_back(table{});
+          break;
+      }
+    } else {
+      r->emplace_back();
+      auto& d = r->back();
+      if (!f.parser.parse(first, last, d))
+        return error{"failed to parse field ", i, ": ",
+                     std::string(split_[i].first, split_[i].second)};
+      // Get the event timestamp if we're at the timestamp field.
+      if (i == static_cast<size_t>(timestamp_field_))
+        if (auto tp = get<time::point>(d))
+          ts = *tp;
+    }
+  }
+  event e{{std::move(event_record), type_}};
+  e.timestamp(ts ? *ts : time::now());
+  return std::move(e);
+}
+
+} // namespace detail
+
+namespace {
+
+// Parses newline-aligned blocks of a Bro log in parallel to other workers.
+struct bro_worker : default_actor {
+  bro_worker() : default_actor{"bro-worker"} {
+  }
+
+  behavior make_behavior() override {
+    return {
+      [=](put_atom, type const& t, std::string const& separator,
+          std::string const& set_separator, std::string const& empty_field,
+          std::string const& unset_field, int timestamp_field) {
+        VAST_DEBUG(this, "switches to log type", t.name());
+        parser_ = {t, separator, set_separator, empty_field, unset_field,
+                   timestamp_field};
+      },
+      [=](uint64_t block, std::string const& lines) {
+        std::vector<event> events;
+        auto f = lines.data();
+        auto l = f + lines.size();
+        events.reserve(std::count(f, l, '\n'));
+        while (f < l) {
+          auto eol = static_cast<char const*>(std::memchr(f, '\n', l - f));
+          if (eol == nullptr)
+            eol = l;
+          util::string_ref line{f, static_cast<size_t>(eol - f)};
+          auto e = parser_.parse(line);
+          if (e) {
+            events.push_back(std::move(*e));
+          } else {
+            VAST_WARN(this, e.error());
+            VAST_WARN(this, "skips line:", line.str());
+          }
+          f = eol + 1;
+        }
+        return make_message(block, std::move(events),
+                            uint64_t{lines.size()});
+      }
+    };
+  }
+
+  source::detail::bro_line_parser parser_;
+};
+
+} // namespace <anonymous>
+
+bro::bro(std::unique_ptr<io::input_stream> is, size_t workers)
+  : line_based<bro>{"bro-source", std::move(is)}, num_workers_{workers} {
+}
+
+behavior bro::make_behavior() {
+  if (num_workers_ == 0)
+    return line_based<bro>::make_behavior();
+  message_handler parallel = {
+    [=](run_atom) {
+      if (!has_sinks()) {
+        VAST_ERROR(this, "cannot run without sinks");
+        quit(exit::error);
+        return;
+      }
+      if (workers_.empty()) {
+        VAST_VERBOSE(this, "spawns", num_workers_, "parser workers");
+        for (size_t i = 0; i < num_workers_; ++i)
+          workers_.push_back(spawn<bro_worker, linked + detached>());
+        if (!is<none>(type_))
+          publish_header();
+      }
+      // Keep every worker busy with up to two blocks to overlap parsing with
+      // reading and shipping.
+      while (!done() && !overloaded() && has_credit()
+             && next_block_ - next_batch_ < 2 * workers_.size())
+        if (!dispatch())
+          done(true);
+      if (done() && next_block_ == next_batch_)
+        send_exit(*this, failed() ? exit::error : exit::done);
+    },
+    [=](uint64_t block, std::vector<event>& events, uint64_t bytes) {
+      completed_.emplace(block, std::make_pair(std::move(events), bytes));
+      // Ship all batches which are next in line.
+      auto i = completed_.begin();
+      while (i != completed_.end() && i->first == next_batch_) {
+        auto& events = i->second.first;
+        auto bytes = i->second.second;
+        // We reserved credit for every line of the block at dispatch, and
+        // give back what skipped lines did not use.
+        VAST_ASSERT(!reserved_.empty());
+        auto lines = reserved_.front();
+        reserved_.pop_front();
+        if (credit_based() && lines > events.size())
+          add_credit(lines - events.size(), 0);
+        if (!events.empty() && has_sinks())
+          ship(std::move(events), bytes, true);
+        ++next_batch_;
+        i = completed_.erase(i);
+      }
+      if (done()) {
+        if (next_block_ == next_batch_)
+          send_exit(*this, failed() ? exit::error : exit::done);
+      } else if (!overloaded() && has_credit()) {
+        send(this, run_atom::value);
+      }
+    }
+  };
+  return parallel.or_else(line_based<bro>::make_behavior());
 }
 
 schema bro::sniff() {
@@ -100,9 +308,9 @@ result<event> bro::extract() {
   if (!this->next_line())
     return {};
   // Check if we encountered a new log file.
-  auto s = util::split(this->line(), separator_);
-  if (s.size() > 0 && s[0].first != s[0].second && *s[0].first == '#') {
-    if (util::starts_with(s[0].first, s[0].second, "#separator")) {
+  auto line = this->line();
+  if (line[0] == '#') {
+    if (util::starts_with(line.begin(), line.end(), "#separator")) {
       VAST_VERBOSE(this, "restarts with new log");
       timestamp_field_ = -1;
       separator_ = " ";
@@ -111,87 +319,100 @@ result<event> bro::extract() {
         return t.error();
       if (!this->next_line())
         return {};
-      s = util::split(this->line(), separator_);
+      line = this->line();
     } else {
       VAST_VERBOSE(this, "ignored comment at line", line_number() << ':',
-                   this->line());
+                   line.str());
       return {};
     }
   }
-  size_t f = 0;
-  size_t depth = 1;
-  record event_record;
-  record* r = &event_record;
-  auto ts = time::now();
-  for (auto& e : type::record::each{*get<type::record>(type_)}) {
-    if (f == s.size()) {
-      VAST_WARN(this, "accessed field", f, "out of bounds");
-      return {};
+  auto e = parser_.parse(line);
+  if (!e) {
+    VAST_WARN(this, e.error());
+    VAST_WARN(this, "skips line:", line.str());
+    return {};
+  }
+  return std::move(*e);
+}
+
+bool bro::dispatch() {
+  if (is<none>(type_)) {
+    if (!this->next_line()) {
+      VAST_ERROR(this, "could not read first line of header");
+      return false;
     }
-    if (e.trace.size() > depth) {
-      for (size_t i = 0; i < e.depth() - depth; ++i) {
-        ++depth;
-        r->push_back(record{});
-        r = get<record>(r->back());
-      }
-    } else if (e.depth() < depth) {
-      r = &event_record;
-      depth = e.depth();
-      for (size_t i = 0; i < depth - 1; ++i)
-        r = get<record>(r->back());
+    auto t = parse_header();
+    if (!t) {
+      VAST_ERROR(this, "failed to parse header:", t.error());
+      return false;
     }
-    if (std::equal(unset_field_.begin(), unset_field_.end(), s[f].first,
-                   s[f].second)) {
-      r->emplace_back(nil);
-    } else if (std::equal(empty_field_.begin(), empty_field_.end(), s[f].first,
-                          s[f].second)) {
-      switch (which(e.trace.back()->type)) {
-        default:
-          VAST_WARN(this, "got invalid empty field", f,
-                    '"' << e.trace.back()->name << "\" of type",
-                    e.trace.back()->type << ':',
-                    std::string(s[f].first, s[f].second));
-          return {};
-        case type::tag::string:
-          r->emplace_back(std::string{});
-          break;
-        case type::tag::vector:
-          r->emplace_back(vector{});
-          break;
-        case type::tag::set:
-          r->emplace_back(vast::set{});
-          break;
-        case type::tag::table:
-          r->emplace_back(table{});
-          break;
+  }
+  std::string block;
+  uint64_t lines = 0;
+  auto more = true;
+  auto start = time::snapshot();
+  while (lines < batch_size()) {
+    if (!this->next_line()) {
+      more = false;
+      break;
+    }
+    auto line = this->line();
+    if (line[0] == '#') {
+      if (!util::starts_with(line.begin(), line.end(), "#separator")) {
+        VAST_VERBOSE(this, "ignored comment at line", line_number() << ':',
+                     line.str());
+        continue;
       }
-    } else {
-      data d;
-      if (!parsers_[f].parse(s[f].first, s[f].second, d)) {
-        VAST_WARN(this, "failed to parse field", f << ':',
-                  std::string(s[f].first, s[f].second));
-        VAST_WARN(this, "skips line:", this->line());
-        return {};
+      // A new log begins. The lines read so far still belong to the previous
+      // header, so we end the block here. Since each worker processes its
+      // messages in order, subsequent blocks see the new header.
+      VAST_VERBOSE(this, "restarts with new log");
+      if (lines > 0) {
+        send_block(std::move(block), lines);
+        lines = 0;
+        block = {};
       }
-      // Get the event timestamp if we're at the timestamp field.
-      if (f == static_cast<size_t>(timestamp_field_))
-        if (auto tp = get<time::point>(d))
-          ts = *tp;
-      r->push_back(std::move(d));
+      timestamp_field_ = -1;
+      separator_ = " ";
+      auto t = parse_header();
+      if (!t) {
+        VAST_ERROR(this, "failed to parse header:", t.error());
+        return false;
+      }
+      continue;
     }
-    ++f;
+    block.append(line.begin(), line.end());
+    block.push_back('\n');
+    ++lines;
   }
-  event e{{std::move(event_record), type_}};
-  e.timestamp(ts);
-  return e;
+  if (lines > 0) {
+    adapt(lines, block.size(), time::snapshot() - start);
+    send_block(std::move(block), lines);
+  }
+  return more;
+}
+
+void bro::send_block(std::string block, uint64_t lines) {
+  // Consuming the credit now rather than when shipping the parsed events
+  // keeps the blocks in flight from exceeding the credit.
+  consume_credit(lines, block.size());
+  reserved_.push_back(lines);
+  send(workers_[next_block_ % workers_.size()], next_block_, std::move(block));
+  ++next_block_;
 }
 
-trial<std::string> bro::parse_header_line(std::string const& line,
+void bro::publish_header() {
+  for (auto& w : workers_)
+    send(w, put_atom::value, type_, separator_, set_separator_, empty_field_,
+         unset_field_, timestamp_field_);
+}
+
+trial<std::string> bro::parse_header_line(util::string_ref line,
                                           std::string const& prefix) {
-  auto s = util::split(line, separator_, "", 1);
+  auto s = util::split(line.begin(), line.end(), separator_, "", 1);
   if (!(s.size() == 2
         && std::equal(prefix.begin(), prefix.end(), s[0].first, s[0].second)))
-    return error{"got invalid header line: " + line};
+    return error{"got invalid header line: " + line.str()};
   return std::string{s[1].first, s[1].second};
 }
 
@@ -312,14 +533,9 @@ trial<void> bro::parse_header() {
       ++i;
     }
   }
-  // Create Bro parsers.
-  auto make_parser = [this](type const& t) {
-    using iterator_type = std::string::const_iterator;
-    return detail::make_bro_parser<iterator_type>(t, set_separator_);
-  };
-  parsers_.resize(flat.fields().size());
-  for (size_t i = 0; i < flat.fields().size(); i++)
-    parsers_[i] = make_parser(flat.fields()[i].type);
+  parser_ = {type_, separator_, set_separator_, empty_field_, unset_field_,
+             timestamp_field_};
+  publish_header();
   return nothing;
 }
 
@@ -1,9 +1,12 @@
 #ifndef VAST_ACTOR_SOURCE_BRO_H
 #define VAST_ACTOR_SOURCE_BRO_H
 
+#include <deque>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "vast/schema.h"
 #include "vast/actor/source/line_based.h"
@@ -11,13 +14,70 @@
 
 namespace vast {
 namespace source {
+namespace detail {
+
+/// Parses the data lines of a Bro log according to the log header.
+/// The parser derives the record layout once from the header and reuses its
+/// buffers across lines, so that parsing a line only allocates the event
+/// itself. Copies share the underlying field parsers, so each thread must
+/// construct its own instance.
+class bro_line_parser {
+public:
+  bro_line_parser() = default;
+
+  /// Constructs a line parser from the values of a Bro log header.
+  /// @param t The record type of the log.
+  /// @param separator The field separator.
+  /// @param set_separator The separator of container elements.
+  /// @param empty_field The value of an empty field.
+  /// @param unset_field The value of an unset field.
+  /// @param timestamp_field The index of the event timestamp field or -1.
+  bro_line_parser(type t, std::string separator, std::string set_separator,
+                  std::string empty_field, std::string unset_field,
+                  int timestamp_field);
+
+  /// Parses a single line into an event.
+  /// @param line The line to parse.
+  /// @returns The event corresponding to *line*.
+  trial<event> parse(util::string_ref line);
+
+private:
+  struct field {
+    std::string name;
+    vast::type type;
+    rule<char const*, data> parser;
+    size_t depth;             // The nesting depth of the enclosing record.
+    std::vector<size_t> open; // The sizes of the records to begin.
+  };
+
+  type type_;
+  std::string separator_;
+  std::string empty_field_;
+  std::string unset_field_;
+  int timestamp_field_ = -1;
+  size_t size_ = 0;
+  std::vector<field> fields_;
+  std::vector<std::pair<char const*, char const*>> split_;
+  std::vector<record*> records_;
+};
+
+} // namespace detail
 
 /// A Bro log file source.
+///
+/// With parallel parsing enabled, the source only splits its input into
+/// newline-aligned blocks and processes the log headers, while a pool of
+/// workers parses the blocks. The source ships the resulting batches in input
+/// order.
 class bro : public line_based<bro> {
 public:
   /// Spawns a Bro source.
   /// @param is The input stream to read Bro logs from.
-  bro(std::unique_ptr<io::input_stream> is);
+  /// @param workers The number of parser workers, or 0 to parse all lines
+  ///                within the source.
+  bro(std::unique_ptr<io::input_stream> is, size_t workers = 0);
+
+  caf::behavior make_behavior() override;
 
   result<event> extract();
 
@@ -26,11 +86,21 @@ public:
   void set(schema const& sch);
 
 private:
-  trial<std::string> parse_header_line(std::string const& line,
+  trial<std::string> parse_header_line(util::string_ref line,
                                        std::string const& prefix);
 
   trial<void> parse_header();
 
+  // Sends the current header to all workers.
+  void publish_header();
+
+  // Reads the next newline-aligned block and dispatches it to a worker.
+  // Returns false if the source has no more input.
+  bool dispatch();
+
+  // Reserves credit for a block and sends it to the next worker.
+  void send_block(std::string block, uint64_t lines);
+
   vast::schema schema_;
   int timestamp_field_ = -1;
   std::string separator_ = " ";
@@ -39,7 +109,15 @@ private:
   std::string unset_field_;
   std::string event_name_prefix_ = "bro";
   type type_;
-  std::vector<rule<std::string::const_iterator, data>> parsers_;
+  detail::bro_line_parser parser_;
+  size_t num_workers_;
+  std::vector<caf::actor> workers_;
+  uint64_t next_block_ = 0;
+  uint64_t next_batch_ = 0;
+  // Parsed blocks waiting to ship, along with their input size.
+  std::map<uint64_t, std::pair<std::vector<event>, uint64_t>> completed_;
+  // The number of lines of each block in flight, in dispatch order.
+  std::deque<uint64_t> reserved_;
 };
 
 } // namespace source
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <limits>
+
+#include "vast/actor/source/flow_table.h"
+#include "vast/util/assert.h"
+
+namespace vast {
+namespace source {
+
+namespace {
+
+// Marks the absence of an entry in the index and the timing wheel.
+constexpr uint32_t nil = std::numeric_limits<uint32_t>::max();
+
+// The upper bound on timing wheel slots. Flows scheduled further out wait in
+// the last slot and get rescheduled when the wheel reaches them.
+constexpr uint64_t max_wheel_size = 1 << 16;
+
+} // namespace <anonymous>
+
+flow_table::flow_table(size_t max_flows, uint64_t max_age,
+                       uint64_t granularity)
+  : max_flows_{std::min(max_flows, size_t{nil - 1})},
+    max_age_{max_age},
+    granularity_{granularity},
+    index_(16, nil),
+    mask_{index_.size() - 1} {
+  VAST_ASSERT(max_flows > 0);
+  VAST_ASSERT(granularity > 0);
+  auto ticks = std::min(max_age_ / granularity_ + 3, max_wheel_size);
+  wheel_.resize(ticks, nil);
+}
+
+flow_table::flow& flow_table::access(detail::connection const& conn,
+                                     uint64_t now) {
+  if (!started_) {
+    current_tick_ = now / granularity_;
+    started_ = true;
+  }
+  auto hash = std::hash<detail::connection>{}(conn);
+  auto i = probe(conn, hash);
+  if (index_[i] != nil) {
+    auto id = index_[i];
+    auto& e = entries_[id];
+    e.referenced = true;
+    if (e.last != now) {
+      e.last = now;
+      unschedule(id);
+      schedule(id);
+    }
+    return e;
+  }
+  if (size_ == max_flows_) {
+    // Advance the clock hand to the first flow without a packet since the
+    // last pass, giving every flow we pass over a second chance.
+    while (entries_[hand_].referenced) {
+      entries_[hand_].referenced = false;
+      hand_ = (hand_ + 1) % entries_.size();
+    }
+    auto victim = hand_;
+    hand_ = (hand_ + 1) % entries_.size();
+    unschedule(victim);
+    erase(victim);
+    i = probe(conn, hash);
+  }
+  if ((size_ + 1) * 2 > index_.size()) {
+    grow();
+    i = probe(conn, hash);
+  }
+  uint32_t id;
+  if (free_.empty()) {
+    id = static_cast<uint32_t>(entries_.size());
+    entries_.emplace_back();
+  } else {
+    id = free_.back();
+    free_.pop_back();
+  }
+  auto& e = entries_[id];
+  e.conn = conn;
+  e.bytes = 0;
+  e.last = now;
+  e.hash = hash;
+  e.referenced = false;
+  e.used = true;
+  index_[i] = id;
+  ++size_;
+  schedule(id);
+  return e;
+}
+
+flow_table::flow const*
+flow_table::find(detail::connection const& conn) const {
+  auto i = probe(conn, std::hash<detail::connection>{}(conn));
+  return index_[i] == nil ? nullptr : &entries_[index_[i]];
+}
+
+void flow_table::expire(uint64_t now) {
+  auto tick = now / granularity_;
+  if (!started_ || tick <= current_tick_)
+    return;
+  // After a gap longer than the wheel, a single turn visits every flow.
+  auto first = current_tick_ + 1;
+  auto last = first + std::min(tick - current_tick_, uint64_t{wheel_.size()});
+  current_tick_ = tick;
+  for (auto t = first; t < last; ++t) {
+    auto slot = t % wheel_.size();
+    auto id = wheel_[slot];
+    wheel_[slot] = nil;
+    while (id != nil) {
+      auto& e = entries_[id];
+      auto next = e.next;
+      if (now > e.last && now - e.last > max_age_)
+        erase(id);
+      else
+        schedule(id); // Not yet due, e.g., after clamping its deadline.
+      id = next;
+    }
+  }
+}
+
+size_t flow_table::size() const {
+  return size_;
+}
+
+size_t flow_table::probe(detail::connection const& conn, size_t hash) const {
+  auto i = hash & mask_;
+  while (index_[i] != nil) {
+    auto& e = entries_[index_[i]];
+    if (e.hash == hash && e.conn == conn)
+      return i;
+    i = (i + 1) & mask_;
+  }
+  return i;
+}
+
+void flow_table::erase(uint32_t id) {
+  auto& e = entries_[id];
+  auto i = probe(e.conn, e.hash);
+  VAST_ASSERT(index_[i] == id);
+  // Backward-shift deletion: move subsequent entries of the cluster into the
+  // hole unless their home slot lies between the hole and their position.
+  // This keeps probe sequences intact without tombstones.
+  auto j = i;
+  for (;;) {
+    j = (j + 1) & mask_;
+    if (index_[j] == nil)
+      break;
+    auto home = entries_[index_[j]].hash & mask_;
+    if (((j - home) & mask_) >= ((j - i) & mask_)) {
+      index_[i] = index_[j];
+      i = j;
+    }
+  }
+  index_[i] = nil;
+  e.used = false;
+  e.referenced = false;
+  free_.push_back(id);
+  --size_;
+}
+
+void flow_table::grow() {
+  std::vector<uint32_t> index(index_.size() * 2, nil);
+  mask_ = index.size() - 1;
+  for (uint32_t id = 0; id < entries_.size(); ++id) {
+    if (!entries_[id].used)
+      continue;
+    auto i = entries_[id].hash & mask_;
+    while (index[i] != nil)
+      i = (i + 1) & mask_;
+    index[i] = id;
+  }
+  index_ = std::move(index);
+}
+
+void flow_table::schedule(uint32_t id) {
+  auto& e = entries_[id];
+  // A flow expires at the first tick at which it has been inactive for more
+  // than the maximum age.
+  auto deadline = e.last + max_age_ + 1;
+  auto tick = deadline / granularity_ + (deadline % granularity_ != 0);
+  if (deadline < e.last || tick >= current_tick_ + wheel_.size())
+    tick = current_tick_ + wheel_.size() - 1;
+  else if (tick <= current_tick_)
+    tick = current_tick_ + 1;
+  e.tick = static_cast<uint32_t>(tick % wheel_.size());
+  e.prev = nil;
+  e.next = wheel_[e.tick];
+  if (e.next != nil)
+    entries_[e.next].prev = id;
+  wheel_[e.tick] = id;
+}
+
+void flow_table::unschedule(uint32_t id) {
+  auto& e = entries_[id];
+  if (e.prev == nil)
+    wheel_[e.tick] = e.next;
+  else
+    entries_[e.prev].next = e.next;
+  if (e.next != nil)
+    entries_[e.next].prev = e.prev;
+}
+
+} // namespace source
+} // namespace vast
@@ -0,0 +1,143 @@
+#ifndef VAST_ACTOR_SOURCE_FLOW_TABLE_H
+#define VAST_ACTOR_SOURCE_FLOW_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "vast/address.h"
+#include "vast/port.h"
+#include "vast/util/hash_combine.h"
+#include "vast/util/operators.h"
+
+namespace vast {
+namespace source {
+namespace detail {
+
+struct connection : util::equality_comparable<connection> {
+  address src;
+  address dst;
+  port sport;
+  port dport;
+
+  friend bool operator==(connection const& lhs, connection const& rhs) {
+    return lhs.src == rhs.src && lhs.dst == rhs.dst && lhs.sport == rhs.sport
+           && lhs.dport == rhs.dport;
+  }
+};
+
+} // namespace detail
+} // namespace source
+} // namespace vast
+
+namespace std {
+
+template <>
+struct hash<vast::source::detail::connection> {
+  size_t operator()(vast::source::detail::connection const& c) const {
+    auto src0 = *reinterpret_cast<uint64_t const*>(&c.src.data()[0]);
+    auto src1 = *reinterpret_cast<uint64_t const*>(&c.src.data()[8]);
+    auto dst0 = *reinterpret_cast<uint64_t const*>(&c.dst.data()[0]);
+    auto dst1 = *reinterpret_cast<uint64_t const*>(&c.dst.data()[8]);
+    auto sprt = c.sport.number();
+    auto dprt = c.dport.number();
+    auto proto = static_cast<uint8_t>(c.sport.type());
+    return vast::util::hash_combine(src0, src1, dst0, dst1, sprt, dprt, proto);
+  }
+};
+
+} // namespace std
+
+namespace vast {
+namespace source {
+
+/// A fixed-capacity table of flows keyed by their connection 5-tuple.
+///
+/// Flows live inline in a contiguous array, and an open-addressing index with
+/// linear probing maps connections to them. A timing wheel schedules each
+/// flow for expiration, so that expiring inactive flows touches only the
+/// flows due, and a full table evicts flows in CLOCK order: a flow survives a
+/// pass of the clock hand if it has seen a packet since the last pass. All
+/// operations take constant time, apart from amortized index growth.
+class flow_table {
+public:
+  /// The state of a single flow.
+  struct flow {
+    detail::connection conn;
+    uint64_t bytes;
+    uint64_t last;
+  };
+
+  /// Constructs a flow table.
+  /// @param max_flows The maximum number of flows to keep.
+  /// @param max_age The number of seconds after the last packet of a flow
+  ///                until its expiration.
+  /// @param granularity The number of seconds per tick of the timing wheel,
+  ///                    i.e., the precision of expirations.
+  /// @pre `max_flows > 0 && granularity > 0`
+  flow_table(size_t max_flows, uint64_t max_age, uint64_t granularity = 1);
+
+  /// Retrieves the flow of a connection, creating it if it does not exist.
+  /// Updates the time of the last packet of the flow and reschedules its
+  /// expiration. If the table is full, a new flow evicts an existing one.
+  /// @param conn The connection of the flow.
+  /// @param now The current time in seconds.
+  /// @returns The flow of *conn*. The reference remains valid until the next
+  ///          modification of the table.
+  flow& access(detail::connection const& conn, uint64_t now);
+
+  /// Looks up a flow without modifying it.
+  /// @param conn The connection of the flow.
+  /// @returns A pointer to the flow of *conn*, or `nullptr` if absent.
+  flow const* find(detail::connection const& conn) const;
+
+  /// Removes all flows that have been inactive for more than the maximum age.
+  /// @param now The current time in seconds.
+  void expire(uint64_t now);
+
+  /// Retrieves the number of flows in the table.
+  size_t size() const;
+
+private:
+  struct entry : flow {
+    size_t hash;
+    uint32_t prev;
+    uint32_t next;
+    uint32_t tick;
+    bool referenced;
+    bool used;
+  };
+
+  // Locates the index slot of a connection, or the empty slot ending its
+  // probe sequence.
+  size_t probe(detail::connection const& conn, size_t hash) const;
+
+  // Removes an entry from the index, the timing wheel, and the table.
+  void erase(uint32_t id);
+
+  // Doubles the size of the index.
+  void grow();
+
+  // Inserts an entry into the timing wheel at its expiration tick.
+  void schedule(uint32_t id);
+
+  // Removes an entry from the timing wheel.
+  void unschedule(uint32_t id);
+
+  size_t max_flows_;
+  uint64_t max_age_;
+  uint64_t granularity_;
+  std::vector<entry> entries_;
+  std::vector<uint32_t> free_;
+  std::vector<uint32_t> index_;
+  size_t mask_;
+  size_t size_ = 0;
+  std::vector<uint32_t> wheel_;
+  uint64_t current_tick_ = 0;
+  bool started_ = false;
+  uint32_t hand_ = 0;
+};
+
+} // namespace source
+} // namespace vast
+
+#endif
@@ -4,9 +4,10 @@
 #include <cassert>
 
 #include "vast/actor/source/base.h"
-#include "vast/io/getline.h"
+#include "vast/io/line_reader.h"
 #include "vast/io/stream.h"
 #include "vast/util/assert.h"
+#include "vast/util/string_ref.h"
 
 namespace vast {
 namespace source {
@@ -21,8 +22,10 @@ public:
   }
 
   /// Retrieves the current line.
-  std::string const& line() const {
-    return line_;
+  /// @returns A reference to the current line which remains valid until the
+  ///          next call to ::next_line.
+  util::string_ref line() const {
+    return line_reader_.line();
   }
 
 protected:
@@ -30,7 +33,9 @@ protected:
   /// @param name The name of the actor.
   /// @param is The input stream to read from.
   line_based(char const* name, std::unique_ptr<io::input_stream> is)
-    : base<Derived>{name}, input_stream_{std::move(is)} {
+    : base<Derived>{name},
+      input_stream_{std::move(is)},
+      line_reader_{*input_stream_} {
     VAST_ASSERT(input_stream_ != nullptr);
   }
 
@@ -39,22 +44,28 @@ protected:
   bool next_line() {
     if (this->done())
       return false;
-    line_.clear();
     // Get the next non-empty line.
-    while (line_.empty())
-      if (io::getline(*input_stream_, line_)) {
-        ++current_;
-      } else {
-        this->done(true);
+    do {
+      if (!line_reader_.next()) {
+        auto status = input_stream_->status();
+        if (status) {
+          this->done(true);
+        } else {
+          VAST_ERROR(this, "failed to read input:", status.error());
+          this->fail();
+        }
         return false;
       }
+      ++current_;
+      this->consumed(line_reader_.line().size() + 1);
+    } while (line_reader_.line().empty());
     return true;
   }
 
 private:
   std::unique_ptr<io::input_stream> input_stream_;
+  io::line_reader line_reader_;
   uint64_t current_ = 0;
-  std::string line_;
 };
 
 } // namespace source
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <limits>
+
+#include "vast/actor/source/multiplexer.h"
+#include "vast/concept/printable/vast/error.h"
+#include "vast/util/assert.h"
+
+using namespace caf;
+
+namespace vast {
+namespace source {
+
+multiplexer::multiplexer(std::vector<std::string> keys, factory make_reader,
+                         size_t max_readers)
+  : flow_controlled_actor{"multiplexer-source"},
+    keys_(std::make_move_iterator(keys.begin()),
+          std::make_move_iterator(keys.end())),
+    make_reader_{std::move(make_reader)},
+    max_readers_{max_readers} {
+  VAST_ASSERT(max_readers_ > 0);
+  trap_exit(true);
+}
+
+void multiplexer::on_exit() {
+  readers_.clear();
+  accountant_ = invalid_actor;
+  sinks_.clear();
+}
+
+behavior multiplexer::make_behavior() {
+  return {
+    [=](exit_msg const& msg) {
+      if (downgrade_exit())
+        return;
+      running_ = false;
+      exit_reason_ = msg.reason;
+      if (msg.reason == exit::kill) {
+        for (auto& r : readers_)
+          send_exit(r.actor, exit::kill);
+        quit(exit::kill);
+        return;
+      }
+      // Readers ship their remaining events when they exit, so we wait for
+      // all of them to go down before our final flush.
+      for (auto& r : readers_)
+        if (!r.finished)
+          send_exit(r.actor, msg.reason);
+      try_quit();
+    },
+    [=](down_msg const& msg) {
+      auto r = find_reader(msg.source);
+      if (r != readers_.end()) {
+        if (msg.reason != exit::done)
+          VAST_WARN(this, "lost reader for", r->key);
+        VAST_DEBUG(this, "finished reading", r->key);
+        r->finished = true;
+        if (exit_reason_)
+          try_quit();
+        else
+          reap();
+        return;
+      }
+      auto sink = std::find_if(sinks_.begin(), sinks_.end(), [&](auto& x) {
+        return x->address() == msg.source;
+      });
+      if (sink != sinks_.end())
+        sinks_.erase(sink);
+      if (sinks_.empty()) {
+        VAST_WARN(this, "has no more sinks");
+        send_exit(*this, exit::done);
+      }
+    },
+    [=](overload_atom) {
+      overloaded(true); // Queue batches until the sinks catch up.
+    },
+    [=](underload_atom) {
+      overloaded(false);
+      flush();
+      reap();
+    },
+    [=](credit_atom, uint64_t events, uint64_t bytes) {
+      add_credit(events, bytes);
+      if (!sinks_.empty())
+        flush();
+      reap();
+    },
+    [=](upstream_atom, actor const&) {
+      // Our readers register themselves as upstream nodes. We throttle them
+      // individually based on their queue length instead.
+    },
+    [=](batch_atom, uint64_t batch_size) {
+      VAST_DEBUG(this, "sets batch size to", batch_size);
+      batch_ = make_message(batch_atom::value, batch_size);
+      for (auto& r : readers_)
+        send(r.actor, batch_);
+    },
+    [=](batch_atom, uint64_t, uint64_t, time::duration) {
+      batch_ = current_message();
+      for (auto& r : readers_)
+        send(r.actor, batch_);
+    },
+    [=](get_atom, schema_atom) {
+      return schema_;
+    },
+    [=](put_atom, schema const& sch) {
+      schema_ = sch;
+      for (auto& r : readers_)
+        send(r.actor, put_atom::value, schema_);
+    },
+    [=](put_atom, sink_atom, actor const& sink) {
+      VAST_DEBUG(this, "adds sink to", sink);
+      monitor(sink);
+      send(sink, upstream_atom::value, this);
+      sinks_.push_back(sink);
+    },
+    [=](put_atom, accountant_atom, actor const& accountant) {
+      VAST_DEBUG(this, "registers accountant", accountant);
+      accountant_ = accountant;
+      send(accountant_, label() + "-events", time::now());
+    },
+    [=](get_atom, sink_atom) {
+      return sinks_;
+    },
+    [=](run_atom) {
+      if (sinks_.empty()) {
+        VAST_ERROR(this, "cannot run without sinks");
+        quit(exit::error);
+        return;
+      }
+      if (running_)
+        return;
+      VAST_VERBOSE(this, "runs", keys_.size(), "readers with up to",
+                   max_readers_, "concurrent readers");
+      running_ = true;
+      reap();
+    },
+    [=](std::vector<event>& events, uint64_t bytes) {
+      auto r = find_reader(current_sender());
+      if (r == readers_.end()) {
+        VAST_WARN(this, "ignores batch from unknown reader", current_sender());
+        return;
+      }
+      r->batches.emplace_back(std::move(events), bytes);
+      if (!r->paused && r->batches.size() >= max_queued_batches) {
+        VAST_DEBUG(this, "pauses reader for", r->key);
+        r->paused = true;
+        send(message_priority::high, r->actor, overload_atom::value);
+      }
+      flush();
+    },
+    catch_unexpected()
+  };
+}
+
+void multiplexer::launch() {
+  while (running_ && readers_.size() < max_readers_ && !keys_.empty()) {
+    auto key = std::move(keys_.front());
+    keys_.pop_front();
+    auto a = make_reader_(key);
+    if (!a) {
+      VAST_ERROR(this, "failed to spawn reader for", key << ':', a.error());
+      continue;
+    }
+    VAST_DEBUG(this, "spawned reader for", key);
+    monitor(*a);
+    if (!schema_.empty())
+      send(*a, put_atom::value, schema_);
+    if (!batch_.empty())
+      send(*a, batch_);
+    send(*a, put_atom::value, sink_atom::value, this);
+    // Readers report the input size of their batches only when they run on
+    // credit. Since we throttle them with overload signals instead, we grant
+    // them unlimited credit.
+    auto unlimited = std::numeric_limits<uint64_t>::max();
+    send(*a, credit_atom::value, unlimited, unlimited);
+    send(*a, run_atom::value);
+    reader r;
+    r.actor = std::move(*a);
+    r.key = std::move(key);
+    readers_.push_back(std::move(r));
+  }
+}
+
+void multiplexer::flush(bool force) {
+  VAST_ASSERT(!sinks_.empty());
+  while (force || (!overloaded() && has_credit())) {
+    // Find the next reader with a pending batch, starting after the one we
+    // served last.
+    auto n = readers_.size();
+    auto i = size_t{0};
+    while (i < n && readers_[(next_reader_ + i) % n].batches.empty())
+      ++i;
+    if (i == n)
+      return;
+    auto& r = readers_[(next_reader_ + i) % n];
+    next_reader_ = (next_reader_ + i + 1) % n;
+    auto events = std::move(r.batches.front().first);
+    auto bytes = r.batches.front().second;
+    r.batches.pop_front();
+    if (r.paused && r.batches.size() < max_queued_batches) {
+      VAST_DEBUG(this, "resumes reader for", r.key);
+      r.paused = false;
+      send(message_priority::high, r.actor, underload_atom::value);
+    }
+    VAST_VERBOSE(this, "produced", events.size(), "events");
+    if (accountant_ != invalid_actor)
+      send(accountant_, uint64_t{events.size()}, time::snapshot());
+    auto& sink = sinks_[next_sink_++ % sinks_.size()];
+    if (credit_based()) {
+      consume_credit(events.size(), bytes);
+      send(sink, std::move(events), bytes);
+    } else {
+      send(sink, std::move(events));
+    }
+  }
+}
+
+void multiplexer::reap() {
+  auto done = [](auto& r) { return r.finished && r.batches.empty(); };
+  readers_.erase(std::remove_if(readers_.begin(), readers_.end(), done),
+                 readers_.end());
+  launch();
+  if (running_ && readers_.empty() && keys_.empty()) {
+    VAST_VERBOSE(this, "finished all readers");
+    send_exit(*this, exit::done);
+  }
+}
+
+void multiplexer::try_quit() {
+  VAST_ASSERT(exit_reason_);
+  auto finished = [](auto& r) { return r.finished; };
+  if (!std::all_of(readers_.begin(), readers_.end(), finished))
+    return;
+  // Ship what we have, regardless of the load of our sinks.
+  overloaded(false);
+  if (!sinks_.empty())
+    flush(true);
+  quit(*exit_reason_);
+}
+
+std::vector<multiplexer::reader>::iterator
+multiplexer::find_reader(actor_addr const& a) {
+  return std::find_if(readers_.begin(), readers_.end(),
+                      [&](auto& r) { return r.actor->address() == a; });
+}
+
+} // namespace source
+} // namespace vast
@@ -0,0 +1,91 @@
+#ifndef VAST_ACTOR_SOURCE_MULTIPLEXER_H
+#define VAST_ACTOR_SOURCE_MULTIPLEXER_H
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vast/event.h"
+#include "vast/optional.h"
+#include "vast/schema.h"
+#include "vast/trial.h"
+#include "vast/actor/actor.h"
+
+namespace vast {
+namespace source {
+
+/// A source which runs multiple readers concurrently, such as one source per
+/// input file or several sources sharing a network interface. The
+/// multiplexer spawns one source per reader key, keeps up to a fixed number
+/// of them running at the same time, and merges their batches into its own
+/// sinks. When the sinks cannot keep up, it forwards the queued batches of
+/// its readers in round-robin order, so that every reader makes progress at
+/// the same rate.
+///
+/// To the outside, the multiplexer behaves like any other source.
+class multiplexer : public flow_controlled_actor {
+public:
+  /// Spawns the source for a given reader key. The multiplexer treats keys
+  /// as opaque and uses them only to start readers and in log messages.
+  using factory = std::function<trial<caf::actor>(std::string const&)>;
+
+  /// Constructs a multiplexer.
+  /// @param keys The reader keys, in the order to start their readers.
+  /// @param make_reader The function spawning a source for a single key.
+  /// @param max_readers The maximum number of sources to run concurrently.
+  /// @pre `max_readers > 0`
+  multiplexer(std::vector<std::string> keys, factory make_reader,
+              size_t max_readers);
+
+  void on_exit() override;
+  caf::behavior make_behavior() override;
+
+private:
+  struct reader {
+    caf::actor actor;
+    std::string key;
+    std::deque<std::pair<std::vector<event>, uint64_t>> batches;
+    bool paused = false;
+    bool finished = false;
+  };
+
+  // The number of batches a reader may queue before we pause it.
+  static constexpr size_t max_queued_batches = 2;
+
+  // Spawns readers until reaching the concurrency limit.
+  void launch();
+
+  // Ships queued batches round-robin across readers until the sinks become
+  // overloaded, the credit runs out, or all queues are empty. When forced,
+  // ships all queued batches.
+  void flush(bool force = false);
+
+  // Removes finished readers without pending batches and terminates when no
+  // work remains.
+  void reap();
+
+  // Ships all queued batches and quits once all readers have gone down.
+  void try_quit();
+
+  std::vector<reader>::iterator find_reader(caf::actor_addr const& a);
+
+  std::deque<std::string> keys_;
+  factory make_reader_;
+  size_t max_readers_;
+  std::vector<reader> readers_;
+  size_t next_reader_ = 0;
+  bool running_ = false;
+  optional<uint32_t> exit_reason_;
+  schema schema_;
+  caf::message batch_;
+  caf::actor accountant_;
+  std::vector<caf::actor> sinks_;
+  size_t next_sink_ = 0;
+};
+
+} // namespace source
+} // namespace vast
+
+#endif
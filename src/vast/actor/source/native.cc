@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstring>
+
+#include "vast/actor/source/native.h"
+#include "vast/concept/printable/vast/error.h"
+#include "vast/concept/serializable/io.h"
+#include "vast/concept/serializable/vast/chunk.h"
+#include "vast/concept/serializable/vast/schema.h"
+#include "vast/detail/native_format.h"
+#include "vast/util/assert.h"
+
+namespace vast {
+namespace source {
+
+native::native(std::unique_ptr<io::input_stream> is)
+  : base<native>{"native-source"}, input_{std::move(is)} {
+  VAST_ASSERT(input_ != nullptr);
+}
+
+schema native::sniff() {
+  // The first frame of the input holds the schema.
+  if (!started_) {
+    auto t = advance();
+    if (!t) {
+      VAST_ERROR(this, t.error());
+      fail();
+    }
+  }
+  return schema_;
+}
+
+void native::set(schema const&) {
+  VAST_WARN(this, "ignores schema, the input carries its own types");
+}
+
+result<event> native::extract() {
+  for (;;) {
+    if (reader_) {
+      auto e = reader_->read();
+      if (e.failed())
+        fail();
+      if (e || e.failed())
+        return e;
+      reader_.reset();
+    }
+    // A damaged file must not look like a successful import.
+    auto t = advance();
+    if (!t) {
+      fail();
+      return t.error();
+    }
+    if (!*t) {
+      done(true);
+      return {};
+    }
+  }
+}
+
+size_t native::read(size_t n) {
+  buffer_.resize(n);
+  size_t got = 0;
+  while (got < n) {
+    void const* data;
+    size_t size;
+    if (!input_->next(&data, &size))
+      break;
+    auto bytes = std::min(size, n - got);
+    std::memcpy(buffer_.data() + got, data, bytes);
+    if (bytes < size)
+      input_->rewind(size - bytes);
+    got += bytes;
+  }
+  consumed(got);
+  return got;
+}
+
+trial<bool> native::advance() {
+  using namespace detail::native_format;
+  if (!started_) {
+    started_ = true;
+    if (read(header_size) < header_size
+        || !std::equal(magic, magic + sizeof(magic), buffer_.begin()))
+      return error{"input is not in native format"};
+    auto v = decode(buffer_.data() + sizeof(magic));
+    if (v != version)
+      return error{"unsupported native format version ", v};
+  }
+  auto got = read(frame_header_size);
+  if (got == 0)
+    return false;
+  if (got < frame_header_size)
+    return error{"truncated frame header"};
+  auto kind = buffer_[0];
+  auto size = decode(buffer_.data() + 1);
+  if (read(size) < size)
+    return error{"truncated frame"};
+  switch (kind) {
+    default:
+      return error{"invalid frame kind ", uint32_t{kind}};
+    case schema_frame: {
+      schema sch;
+      load(buffer_, sch);
+      auto merged = schema::merge(schema_, sch);
+      if (merged)
+        schema_ = std::move(*merged);
+      else
+        VAST_WARN(this, "ignores types:", merged.error());
+      break;
+    }
+    case chunk_frame:
+      VAST_ASSERT(!reader_);
+      load(buffer_, chunk_);
+      reader_ = std::make_unique<chunk::reader>(chunk_);
+      break;
+  }
+  return true;
+}
+
+} // namespace source
+} // namespace vast
@@ -0,0 +1,50 @@
+#ifndef VAST_ACTOR_SOURCE_NATIVE_H
+#define VAST_ACTOR_SOURCE_NATIVE_H
+
+#include <memory>
+#include <vector>
+
+#include "vast/chunk.h"
+#include "vast/schema.h"
+#include "vast/actor/source/base.h"
+#include "vast/io/stream.h"
+
+namespace vast {
+namespace source {
+
+/// A source reading events in VAST's native binary format, as written by the
+/// *native* sink. It decompresses chunks directly into events without any
+/// parsing.
+class native : public base<native> {
+public:
+  /// Spawns a native source.
+  /// @param is The input stream to read from.
+  native(std::unique_ptr<io::input_stream> is);
+
+  schema sniff();
+
+  void set(schema const& sch);
+
+  result<event> extract();
+
+private:
+  // Reads up to *n* bytes into the buffer.
+  // @returns The number of bytes read.
+  size_t read(size_t n);
+
+  // Processes the next frame, reading the file header first if necessary.
+  // @returns `false` at the end of the input.
+  trial<bool> advance();
+
+  std::unique_ptr<io::input_stream> input_;
+  std::vector<uint8_t> buffer_;
+  bool started_ = false;
+  schema schema_;
+  chunk chunk_;
+  std::unique_ptr<chunk::reader> reader_;
+};
+
+} // namespace source
+} // namespace vast
+
+#endif
@@ -0,0 +1,124 @@
+#include <netinet/in.h>
+
+#include <algorithm>
+
+#include "vast/actor/source/packet.h"
+#include "vast/detail/pcap_packet_type.h"
+#include "vast/util/assert.h"
+#include "vast/util/byte_swap.h"
+
+namespace vast {
+namespace source {
+
+packet_decoder::packet_decoder(uint64_t cutoff, size_t max_flows,
+                               size_t max_age, size_t expire_interval)
+  : packet_type{vast::detail::pcap_packet_type},
+    flows_{max_flows, max_age, std::max(expire_interval, size_t{1})},
+    cutoff_{cutoff} {
+}
+
+result<event> packet_decoder::decode(uint8_t const* data, size_t captured,
+                                     size_t length, time::point timestamp) {
+  if (captured < 14)
+    return {}; // Skip truncated frames.
+  // Parse packet.
+  detail::connection conn;
+  auto packet_size = length - 14;
+  auto layer3 = data + 14;
+  uint8_t const* layer4 = nullptr;
+  uint8_t layer4_proto = 0;
+  auto layer2_type = *reinterpret_cast<uint16_t const*>(data + 12);
+  uint64_t payload_size = packet_size;
+  switch (util::byte_swap<network_endian, host_endian>(layer2_type)) {
+    default:
+      return {}; // Skip all non-IP packets.
+    case 0x0800: {
+      if (captured < 14 + 20)
+        return error{"IPv4 header too short"};
+      size_t header_size = (*layer3 & 0x0f) * 4;
+      if (header_size < 20)
+        return error{"IPv4 header too short: ", header_size, " bytes"};
+      auto orig_h = reinterpret_cast<uint32_t const*>(layer3 + 12);
+      auto resp_h = reinterpret_cast<uint32_t const*>(layer3 + 16);
+      conn.src = {orig_h, address::ipv4, address::network};
+      conn.dst = {resp_h, address::ipv4, address::network};
+      layer4_proto = *(layer3 + 9);
+      layer4 = layer3 + header_size;
+      payload_size -= header_size;
+    } break;
+    case 0x86dd: {
+      if (captured < 14 + 40)
+        return error{"IPv6 header too short"};
+      auto orig_h = reinterpret_cast<uint32_t const*>(layer3 + 8);
+      auto resp_h = reinterpret_cast<uint32_t const*>(layer3 + 24);
+      conn.src = {orig_h, address::ipv6, address::network};
+      conn.dst = {resp_h, address::ipv6, address::network};
+      layer4_proto = *(layer3 + 6);
+      layer4 = layer3 + 40;
+      payload_size -= 40;
+    } break;
+  }
+  // The transport headers we inspect must lie within the captured bytes.
+  auto end = data + captured;
+  size_t layer4_size = layer4 < end ? end - layer4 : 0;
+  if (layer4_proto == IPPROTO_TCP && layer4_size >= 13) {
+    VAST_ASSERT(layer4);
+    auto orig_p = *reinterpret_cast<uint16_t const*>(layer4);
+    auto resp_p = *reinterpret_cast<uint16_t const*>(layer4 + 2);
+    orig_p = util::byte_swap<network_endian, host_endian>(orig_p);
+    resp_p = util::byte_swap<network_endian, host_endian>(resp_p);
+    conn.sport = {orig_p, port::tcp};
+    conn.dport = {resp_p, port::tcp};
+    auto data_offset = *reinterpret_cast<uint8_t const*>(layer4 + 12) >> 4;
+    payload_size -= data_offset * 4;
+  } else if (layer4_proto == IPPROTO_UDP && layer4_size >= 4) {
+    VAST_ASSERT(layer4);
+    auto orig_p = *reinterpret_cast<uint16_t const*>(layer4);
+    auto resp_p = *reinterpret_cast<uint16_t const*>(layer4 + 2);
+    orig_p = util::byte_swap<network_endian, host_endian>(orig_p);
+    resp_p = util::byte_swap<network_endian, host_endian>(resp_p);
+    conn.sport = {orig_p, port::udp};
+    conn.dport = {resp_p, port::udp};
+    payload_size -= 8;
+  } else if (layer4_proto == IPPROTO_ICMP && layer4_size >= 2) {
+    VAST_ASSERT(layer4);
+    auto message_type = *reinterpret_cast<uint8_t const*>(layer4);
+    auto message_code = *reinterpret_cast<uint8_t const*>(layer4 + 1);
+    conn.sport = {message_type, port::icmp};
+    conn.dport = {message_code, port::icmp};
+    payload_size -= 8; // TODO: account for variable-size data.
+  }
+  // Parse packet timestamp
+  uint64_t packet_time = timestamp.time_since_epoch().seconds();
+  auto& flow_size = flows_.access(conn, packet_time).bytes;
+  if (flow_size == cutoff_)
+    return {};
+  if (flow_size + payload_size <= cutoff_) {
+    flow_size += payload_size;
+  } else {
+    // Trim the last packet so that it fits.
+    packet_size -= flow_size + payload_size - cutoff_;
+    flow_size = cutoff_;
+  }
+  // Evict all flows that have been inactive for a while. The flow table
+  // only visits the flows due since the last call.
+  flows_.expire(packet_time);
+  // Assemble packet.
+  record packet;
+  record meta;
+  meta.emplace_back(std::move(conn.src));
+  meta.emplace_back(std::move(conn.dst));
+  meta.emplace_back(std::move(conn.sport));
+  meta.emplace_back(std::move(conn.dport));
+  packet.emplace_back(std::move(meta));
+  // We start with the network layer and skip the link layer. Snapped frames
+  // contain only part of the packet.
+  auto str = reinterpret_cast<char const*>(data + 14);
+  packet.emplace_back(std::string{str, std::min(packet_size, captured - 14)});
+  event e{{std::move(packet), packet_type}};
+  e.timestamp(timestamp);
+  return std::move(e);
+}
+
+} // namespace source
+} // namespace vast
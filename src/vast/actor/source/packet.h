@@ -0,0 +1,49 @@
+#ifndef VAST_ACTOR_SOURCE_PACKET_H
+#define VAST_ACTOR_SOURCE_PACKET_H
+
+#include "vast/event.h"
+#include "vast/result.h"
+#include "vast/time.h"
+#include "vast/type.h"
+#include "vast/actor/source/flow_table.h"
+
+namespace vast {
+namespace source {
+
+/// Turns Ethernet frames into packet events. The decoder keeps per-flow
+/// state to skip packets after a flow exceeds a cutoff, which all sources
+/// capturing packets share.
+class packet_decoder {
+public:
+  /// Constructs a packet decoder.
+  /// @param cutoff The number of bytes to keep per flow.
+  /// @param max_flows The maximum number of flows to keep state for.
+  /// @param max_age The number of seconds to wait since the last seen packet
+  ///                before evicting the corresponding flow.
+  /// @param expire_interval The number of seconds between successive expire
+  ///                        passes over the flow table.
+  packet_decoder(uint64_t cutoff, size_t max_flows, size_t max_age,
+                 size_t expire_interval);
+
+  /// Decodes an Ethernet frame.
+  /// @param data The frame, starting at the link layer.
+  /// @param captured The number of bytes in *data*.
+  /// @param length The length of the frame on the wire.
+  /// @param timestamp The time when the frame arrived.
+  /// @returns The packet event, nothing if the frame was skipped, or an error
+  ///          for a malformed frame.
+  result<event> decode(uint8_t const* data, size_t captured, size_t length,
+                       time::point timestamp);
+
+  /// The type of packet events.
+  type packet_type;
+
+private:
+  flow_table flows_;
+  uint64_t cutoff_;
+};
+
+} // namespace source
+} // namespace vast
+
+#endif
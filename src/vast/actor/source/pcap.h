@@ -3,50 +3,9 @@
 
 #include <chrono>
 #include <pcap.h>
-#include <unordered_map>
-#include <random>
 #include "vast/schema.h"
 #include "vast/actor/source/base.h"
-#include "vast/util/hash_combine.h"
-#include "vast/util/operators.h"
-
-namespace vast {
-namespace source {
-namespace detail {
-
-struct connection : util::equality_comparable<connection> {
-  address src;
-  address dst;
-  port sport;
-  port dport;
-
-  friend bool operator==(connection const& lhs, connection const& rhs) {
-    return lhs.src == rhs.src && lhs.dst == rhs.dst && lhs.sport == rhs.sport
-           && lhs.dport == rhs.dport;
-  }
-};
-
-} // namespace detail
-} // namespace source
-} // namespace vast
-
-namespace std {
-
-template <>
-struct hash<vast::source::detail::connection> {
-  size_t operator()(vast::source::detail::connection const& c) const {
-    auto src0 = *reinterpret_cast<uint64_t const*>(&c.src.data()[0]);
-    auto src1 = *reinterpret_cast<uint64_t const*>(&c.src.data()[8]);
-    auto dst0 = *reinterpret_cast<uint64_t const*>(&c.dst.data()[0]);
-    auto dst1 = *reinterpret_cast<uint64_t const*>(&c.dst.data()[8]);
-    auto sprt = c.sport.number();
-    auto dprt = c.dport.number();
-    auto proto = static_cast<uint8_t>(c.sport.type());
-    return vast::util::hash_combine(src0, src1, dst0, dst1, sprt, dprt, proto);
-  }
-};
-
-} // namespace std
+#include "vast/actor/source/packet.h"
 
 namespace vast {
 namespace source {
@@ -79,22 +38,14 @@ public:
   result<event> extract();
 
 private:
-  struct connection_state {
-    uint64_t bytes;
-    uint64_t last;
-  };
-
   std::string name_;
-  type packet_type_;
-  pcap_t* pcap_ = nullptr;
-  pcap_pkthdr* packet_header_ = nullptr;
-  std::unordered_map<detail::connection, connection_state> flows_;
+  packet_decoder decoder_;
   uint64_t cutoff_;
   size_t max_flows_;
-  std::mt19937 generator_;
   uint64_t max_age_;
   uint64_t expire_interval_;
-  uint64_t last_expire_ = 0;
+  pcap_t* pcap_ = nullptr;
+  pcap_pkthdr* packet_header_ = nullptr;
   std::chrono::nanoseconds last_timestamp_;
   int64_t pseudo_realtime_;
 };
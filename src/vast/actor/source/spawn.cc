@@ -1,16 +1,29 @@
+#include <glob.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
 #include <caf/all.hpp>
 #include <caf/detail/scope_guard.hpp>
 
 #include "vast/config.h"
 #include "vast/actor/source/bro.h"
 #include "vast/actor/source/bgpdump.h"
+#include "vast/actor/source/multiplexer.h"
+#include "vast/actor/source/native.h"
 #include "vast/actor/source/test.h"
 #include "vast/concept/parseable/vast/detail/to_schema.h"
 #include "vast/concept/printable/to_string.h"
 #include "vast/concept/printable/vast/schema.h"
+#include "vast/io/decompressing_stream.h"
 #include "vast/io/file_stream.h"
 #include "vast/util/posix.h"
 
+#ifdef VAST_HAVE_AF_PACKET
+#include "vast/actor/source/af_packet.h"
+#endif
+
 #ifdef VAST_HAVE_PCAP
 #include "vast/actor/source/pcap.h"
 #endif
@@ -21,22 +34,76 @@ using namespace std::string_literals;
 namespace vast {
 namespace source {
 
+namespace {
+
+// Expands the argument of -r into the list of files to read. A directory
+// stands for all regular files inside it, and a pattern containing
+// wildcards for all matching paths, both in lexicographical order. An
+// existing file stands for itself, even if its name contains wildcard
+// characters, because the per-file readers expand their input again.
+std::vector<path> expand_input(std::string const& input) {
+  if (input == "-")
+    return {input};
+  auto p = path{input};
+  if (p.is_regular_file())
+    return {p};
+  if (p.is_directory()) {
+    std::vector<path> files;
+    traverse(p, [&](path const& x) {
+      if (x.is_regular_file())
+        files.push_back(x);
+      return true;
+    });
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+  if (input.find_first_of("*?[") == std::string::npos)
+    return {p};
+  std::vector<path> files;
+  glob_t g;
+  if (::glob(input.c_str(), 0, nullptr, &g) == 0)
+    for (size_t i = 0; i < g.gl_pathc; ++i)
+      files.emplace_back(g.gl_pathv[i]);
+  ::globfree(&g);
+  return files;
+}
+
+} // namespace <anonymous>
+
 trial<caf::actor> spawn(message const& params) {
   auto batch_size = uint64_t{100000};
+  auto batch_bytes = uint64_t{16} << 20;
+  auto batch_latency = uint64_t{1000};
   auto schema_file = ""s;
   auto input = "-"s;
+  auto max_files = uint64_t{std::max(1u, std::thread::hardware_concurrency())};
   auto r = params.extract_opts({
     {"batch,b", "number of events to ingest at once", batch_size},
+    {"batch-bytes,B", "input bytes per batch (0 = unlimited)", batch_bytes},
+    {"batch-latency,L", "milliseconds to fill a batch (0 = unlimited)",
+     batch_latency},
     {"schema,s", "alternate schema file", schema_file},
-    {"read,r", "path to read events from", input},
-    {"uds,u", "treat -r as UNIX domain socket to connect to"}
+    {"read,r", "path, directory, or glob to read events from", input},
+    {"uds,u", "treat -r as UNIX domain socket to connect to"},
+    {"files,n", "number of files to read concurrently", max_files}
   });
   auto& format = params.get_as<std::string>(0);
-  // The "pcap" and "test" sources manually verify the presence of
+  // The packet capture and "test" sources manually verify the presence of
   // input. All other sources are file-based and we setup their input
   // stream here.
+  // Line-based sources parse lines in place from the stream buffer, so we
+  // read large blocks to reduce the number of syscalls and partial lines.
+  static constexpr size_t block_size = 1 << 20;
   std::unique_ptr<io::input_stream> in;
-  if (!(format == "pcap" || format == "test")) {
+  std::vector<path> files;
+  if (!(format == "pcap" || format == "af_packet" || format == "test")) {
+    if (r.opts.count("uds") == 0) {
+      files = expand_input(input);
+      if (files.empty())
+        return error{"no files matching ", input};
+      if (max_files == 0)
+        return error{"need to read at least one file at a time"};
+    }
     if (r.opts.count("uds") > 0) {
       if (input == "-")
         return error{"cannot use stdin as UNIX domain socket"};
@@ -44,9 +111,17 @@ trial<caf::actor> spawn(message const& params) {
       if (!uds)
         return error{"failed to connect to UNIX domain socket at ", input};
       auto remote_fd = uds.recv_fd(); // Blocks!
-      in = std::make_unique<io::file_input_stream>(remote_fd);
-    } else {
-      in = std::make_unique<io::file_input_stream>(input);
+      in = std::make_unique<io::file_input_stream>(
+        remote_fd, close_on_destruction, block_size);
+    } else if (files.size() == 1) {
+      in = std::make_unique<io::file_input_stream>(files[0], block_size);
+    }
+    // Compressed input gets decompressed in a separate thread.
+    if (in) {
+      auto t = io::make_decompressing_input_stream(std::move(in), block_size);
+      if (!t)
+        return t.error();
+      in = std::move(*t);
     }
   }
   // Facilitate shutdown when returning with error.
@@ -54,8 +129,22 @@ trial<caf::actor> spawn(message const& params) {
   auto guard = caf::detail::make_scope_guard(
     [&] { anon_send_exit(src, exit::error); }
   );
-  // Spawn a source according to format.
-  if (format == "pcap") {
+  // Spawn a source according to format. With multiple input files, a
+  // multiplexer spawns one source per file by invoking this function again
+  // with the format-specific options and a single file as input.
+  if (files.size() > 1
+      && (format == "bro" || format == "bgpdump" || format == "native")) {
+    auto options = r.remainder.drop(1);
+    auto make_reader = [=](std::string const& file) {
+      return spawn(make_message(format, "-r"s, file) + options);
+    };
+    std::vector<std::string> keys;
+    keys.reserve(files.size());
+    for (auto& file : files)
+      keys.push_back(file.str());
+    src = caf::spawn<multiplexer, priority_aware>(std::move(keys),
+                                                    make_reader, max_files);
+  } else if (format == "pcap") {
 #ifndef VAST_HAVE_PCAP
     return error{"not compiled with pcap support"};
 #else
@@ -79,6 +168,50 @@ trial<caf::actor> spawn(message const& params) {
       return error{"no input specified (-r or -i)"};
     src = caf::spawn<pcap, priority_aware + detached>(
       input, cutoff, flow_max, flow_age, flow_expiry, pseudo_realtime);
+#endif
+  } else if (format == "af_packet") {
+#ifndef VAST_HAVE_AF_PACKET
+    return error{"not compiled with AF_PACKET support"};
+#else
+    auto flow_max = uint64_t{1} << 20;
+    auto flow_age = 60u;
+    auto flow_expiry = 10u;
+    auto cutoff = std::numeric_limits<size_t>::max();
+    auto fanout = uint64_t{1};
+    auto block_size = uint64_t{1} << 22;
+    auto blocks = uint64_t{64};
+    r = r.remainder.extract_opts({
+      {"interface,i", "the interface to read packets from", input},
+      {"cutoff,c", "skip flow packets after this many bytes", cutoff},
+      {"flow-max,m", "number of concurrent flows to track", flow_max},
+      {"flow-age,a", "max flow lifetime before eviction", flow_age},
+      {"flow-expiry,e", "flow table expiration interval", flow_expiry},
+      {"fanout,f", "number of sources sharing the interface", fanout},
+      {"block-size,k", "bytes per ring block", block_size},
+      {"blocks,N", "number of ring blocks per source", blocks}
+    });
+    if (!r.error.empty())
+      return error{std::move(r.error)};
+    if (input.empty() || input == "-")
+      return error{"no interface specified (-i)"};
+    if (fanout == 0)
+      return error{"need at least one source"};
+    if (fanout == 1) {
+      src = caf::spawn<af_packet, priority_aware + detached>(
+        input, cutoff, flow_max, flow_age, flow_expiry, 0, block_size, blocks);
+    } else {
+      // All sources join the same fanout group, which the kernel identifies
+      // per interface. Our process ID keeps concurrent imports apart.
+      auto group = static_cast<uint16_t>(::getpid() % 0xffff + 1);
+      auto make_reader = [=](std::string const& interface) -> trial<actor> {
+        return caf::spawn<af_packet, priority_aware + detached>(
+          interface, cutoff, flow_max, flow_age, flow_expiry, group,
+          block_size, blocks);
+      };
+      std::vector<std::string> interfaces(fanout, input);
+      src = caf::spawn<multiplexer, priority_aware>(std::move(interfaces),
+                                                      make_reader, fanout);
+    }
 #endif
   } else if (format == "test") {
     auto id = event_id{0};
@@ -94,9 +227,17 @@ trial<caf::actor> spawn(message const& params) {
     // Therefore we can use the input channel for the schema.
     schema_file = input;
   } else if (format == "bro") {
-    src = caf::spawn<bro, priority_aware + detached>(std::move(in));
+    auto parsers = uint64_t{0};
+    r = r.remainder.extract_opts({
+      {"parsers,p", "number of parallel parser workers", parsers}
+    });
+    if (!r.error.empty())
+      return error{std::move(r.error)};
+    src = caf::spawn<bro, priority_aware + detached>(std::move(in), parsers);
   } else if (format == "bgpdump") {
     src = caf::spawn<bgpdump, priority_aware + detached>(std::move(in));
+  } else if (format == "native") {
+    src = caf::spawn<native, priority_aware + detached>(std::move(in));
   } else {
     return error{"invalid import format: ", format};
   }
@@ -111,7 +252,8 @@ trial<caf::actor> spawn(message const& params) {
     anon_send(src, put_atom::value, *s);
   }
   // Set parameters.
-  anon_send(src, batch_atom::value, batch_size);
+  anon_send(src, batch_atom::value, batch_size, batch_bytes,
+            time::duration{time::milliseconds(batch_latency)});
   // Done.
   guard.disable();
   return src;
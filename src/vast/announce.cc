@@ -184,6 +184,7 @@ void announce_types() {
   // std::vector<T>
   announce<std::vector<data>>("std::vector<vast::data>");
   announce<std::vector<event>>("std::vector<vast::event>");
+  announce<std::vector<type>>("std::vector<vast::type>");
   announce<std::vector<value>>("std::vector<vast::value>");
   announce<std::vector<uuid>>("std::vector<vast::uuid>");
   announce<util::radix_tree<caf::message>>(
@@ -43,8 +43,7 @@ public:
               >{},
          bool
        > {
-    inner_attribute x;
-    if (!parser_.parse(f, l, x))
+    if (!parser_.parse(f, l, unused))
       return false;
     action_();
     return true;
@@ -77,8 +76,7 @@ public:
               >::value,
          bool
        > {
-    inner_attribute x;
-    if (!parser_.parse(f, l, x))
+    if (!parser_.parse(f, l, unused))
       return false;
     a = action_();
     return true;
@@ -2,6 +2,7 @@
 #define VAST_CONCEPT_PARSEABLE_CORE_DIFFERENCE_H
 
 #include "vast/concept/parseable/core/parser.h"
+#include "vast/concept/parseable/detail/char_helpers.h"
 
 namespace vast {
 
@@ -25,6 +26,17 @@ public:
     return false;
   }
 
+  // A difference of two character predicates is a predicate itself, e.g.,
+  // `any - ','`.
+  template <typename L = Lhs, typename R = Rhs>
+  auto test(char c) const
+    -> std::enable_if_t<
+         detail::is_char_predicate<L>{} && detail::is_char_predicate<R>{},
+         bool
+       > {
+    return lhs_.test(c) && ! rhs_.test(c);
+  }
+
 private:
   Lhs lhs_;
   Rhs rhs_;
@@ -19,6 +19,15 @@ public:
     return parser_.parse(f, l, unused);
   }
 
+  template <typename P = Parser>
+  auto test(char c) const -> decltype(std::declval<P const&>().test(c)) {
+    return parser_.test(c);
+  }
+
+  Parser const& parser() const {
+    return parser_;
+  }
+
 private:
   Parser parser_;
 };
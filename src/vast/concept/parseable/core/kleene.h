@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "vast/concept/parseable/core/parser.h"
+#include "vast/concept/parseable/detail/char_helpers.h"
 #include "vast/concept/parseable/detail/container.h"
 
 namespace vast {
@@ -19,12 +20,31 @@ public:
 
   template <typename Iterator, typename Attribute>
   bool parse(Iterator& f, Iterator const& l, Attribute& a) const {
+    return parse_impl(f, l, a, detail::is_char_predicate<Parser>{});
+  }
+
+private:
+  // Scans the entire run of matching characters before appending them to
+  // the attribute at once.
+  template <typename Iterator, typename Attribute>
+  bool parse_impl(Iterator& f, Iterator const& l, Attribute& a,
+                  std::true_type) const {
+    auto i = f;
+    while (i != l && parser_.test(*i))
+      ++i;
+    detail::absorb_run<Parser>(a, f, i);
+    f = i;
+    return true;
+  }
+
+  template <typename Iterator, typename Attribute>
+  bool parse_impl(Iterator& f, Iterator const& l, Attribute& a,
+                  std::false_type) const {
     while (container::parse(parser_, f, l, a))
       ;
     return true;
   }
 
-private:
   Parser parser_;
 };
 
@@ -4,6 +4,7 @@
 #include <type_traits>
 
 #include "vast/concept/parseable/detail/as_parser.h"
+#include "vast/concept/parseable/detail/fuse.h"
 
 namespace vast {
 
@@ -101,11 +102,14 @@ auto operator%(LHS&& lhs, RHS&& rhs)
           detail::as_parser(std::forward<RHS>(rhs))};
 }
 
+// Adjacent literals in a sequence collapse into a single string literal, so
+// that parsing them requires only one comparison.
 template <typename LHS, typename RHS>
 auto operator>>(LHS&& lhs, RHS&& rhs)
-  -> decltype(detail::as_parser<sequence_parser>(lhs, rhs)) {
-  return {detail::as_parser(std::forward<LHS>(lhs)),
-          detail::as_parser(std::forward<RHS>(rhs))};
+  -> decltype(detail::fuse(detail::as_parser<sequence_parser>(lhs, rhs))) {
+  return detail::fuse(
+    detail::as_parser<sequence_parser>(std::forward<LHS>(lhs),
+                                       std::forward<RHS>(rhs)));
 }
 
 template <typename LHS, typename RHS>
@@ -13,13 +13,13 @@ namespace detail {
 
 template <typename Iterator, typename Attribute>
 struct abstract_rule {
-  ~abstract_rule() = default;
+  virtual ~abstract_rule() = default;
   virtual bool parse(Iterator& f, Iterator const& l, unused_type) const = 0;
   virtual bool parse(Iterator& f, Iterator const& l, Attribute& a) const = 0;
 };
 
 template <typename Parser, typename Iterator, typename Attribute>
-class rule_definition : public abstract_rule<Iterator, Attribute> {
+class rule_definition final : public abstract_rule<Iterator, Attribute> {
 public:
   explicit rule_definition(Parser p) : parser_(std::move(p)) {
   }
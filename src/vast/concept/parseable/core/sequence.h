@@ -68,6 +68,14 @@ public:
     return false;
   }
 
+  Lhs const& lhs() const {
+    return lhs_;
+  }
+
+  Rhs const& rhs() const {
+    return rhs_;
+  }
+
 private:
   template <typename T>
   static constexpr auto depth_helper()
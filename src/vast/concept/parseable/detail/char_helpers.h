@@ -2,8 +2,11 @@
 #define VAST_CONCEPT_PARSEABLE_DETAIL_CHAR_HELPERS_H
 
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "vast/concept/support/unused_type.h"
+
 namespace vast {
 namespace detail {
 
@@ -20,6 +23,54 @@ inline void absorb(std::vector<char> v, char c) {
   v.push_back(c);
 }
 
+/// Appends a range of characters to an attribute.
+template <typename Attribute, typename Iterator>
+void absorb(Attribute& a, Iterator begin, Iterator end) {
+  a.insert(a.end(), begin, end);
+}
+
+template <typename Iterator>
+void absorb(unused_type, Iterator, Iterator) {
+  // nop
+}
+
+template <typename Attribute, typename Iterator>
+void absorb_run(Attribute&, Iterator, Iterator, std::true_type) {
+  // nop
+}
+
+template <typename Attribute, typename Iterator>
+void absorb_run(Attribute& a, Iterator begin, Iterator end, std::false_type) {
+  absorb(a, begin, end);
+}
+
+/// Appends a run of characters that a repetition of a parser scanned to an
+/// attribute, unless the parser has no attribute, as with `ignore(p)`. This
+/// matches repeatedly parsing into `unused`.
+template <typename Parser, typename Attribute, typename Iterator>
+void absorb_run(Attribute& a, Iterator begin, Iterator end) {
+  using unused = std::is_same<typename Parser::attribute, unused_type>;
+  absorb_run(a, begin, end, unused{});
+}
+
+/// Checks whether a parser consumes exactly one character that satisfies a
+/// predicate, exposed as `bool test(char) const`. Repetitions of such parsers
+/// can scan an entire run of characters without going through the parser
+/// interface for each character.
+template <typename Parser, typename = void>
+struct is_char_predicate : std::false_type {};
+
+template <typename Parser>
+struct is_char_predicate<
+  Parser,
+  std::enable_if_t<
+    std::is_same<
+      decltype(std::declval<Parser const&>().test(char{})),
+      bool
+    >{}
+  >
+> : std::true_type {};
+
 } // namespace detail
 } // namespace vast
 
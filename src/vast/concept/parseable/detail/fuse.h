@@ -0,0 +1,74 @@
+#ifndef VAST_CONCEPT_PARSEABLE_DETAIL_FUSE_H
+#define VAST_CONCEPT_PARSEABLE_DETAIL_FUSE_H
+
+#include <string>
+#include <type_traits>
+
+#include "vast/concept/parseable/core/ignore.h"
+#include "vast/concept/parseable/core/sequence.h"
+#include "vast/concept/parseable/string/char.h"
+#include "vast/concept/parseable/string/string.h"
+
+namespace vast {
+namespace detail {
+
+// A literal is a character or string whose attribute gets ignored, as
+// created by detail::as_parser or parsers::lit.
+template <typename>
+struct is_literal_parser : std::false_type {};
+
+template <>
+struct is_literal_parser<ignore_parser<char_parser>> : std::true_type {};
+
+template <>
+struct is_literal_parser<ignore_parser<string_parser>> : std::true_type {};
+
+inline void append_literal(std::string& str,
+                           ignore_parser<char_parser> const& p) {
+  str += p.parser().character();
+}
+
+inline void append_literal(std::string& str,
+                           ignore_parser<string_parser> const& p) {
+  str += p.parser().str();
+}
+
+template <typename Lhs, typename Rhs>
+ignore_parser<string_parser> fuse_literals(Lhs const& lhs, Rhs const& rhs) {
+  std::string str;
+  append_literal(str, lhs);
+  append_literal(str, rhs);
+  return ignore(string_parser{std::move(str)});
+}
+
+/// Leaves a parser as is when there is nothing to fuse.
+template <typename Parser>
+Parser fuse(Parser p) {
+  return p;
+}
+
+/// Fuses a sequence of two literals into a single string literal.
+template <typename Lhs, typename Rhs>
+auto fuse(sequence_parser<Lhs, Rhs> p)
+  -> std::enable_if_t<
+       is_literal_parser<Lhs>{} && is_literal_parser<Rhs>{},
+       ignore_parser<string_parser>
+     > {
+  return fuse_literals(p.lhs(), p.rhs());
+}
+
+/// Fuses a trailing literal into the literal at the end of a sequence, e.g.,
+/// `x >> ':' >> ' '` becomes `x >> ": "`.
+template <typename T, typename Lhs, typename Rhs>
+auto fuse(sequence_parser<sequence_parser<T, Lhs>, Rhs> p)
+  -> std::enable_if_t<
+       is_literal_parser<Lhs>{} && is_literal_parser<Rhs>{},
+       sequence_parser<T, ignore_parser<string_parser>>
+     > {
+  return {p.lhs().lhs(), fuse_literals(p.lhs().rhs(), p.rhs())};
+}
+
+} // namespace detail
+} // namespace vast
+
+#endif
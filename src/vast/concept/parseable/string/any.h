@@ -2,6 +2,7 @@
 #define VAST_CONCEPT_PARSEABLE_STRING_ANY_H
 
 #include "vast/concept/parseable/core/parser.h"
+#include "vast/concept/parseable/detail/char_helpers.h"
 
 namespace vast {
 
@@ -16,6 +17,10 @@ struct any_parser : public parser<any_parser> {
     ++f;
     return true;
   }
+
+  bool test(char) const {
+    return true;
+  }
 };
 
 template <>
@@ -23,6 +23,14 @@ public:
     return true;
   }
 
+  bool test(char c) const {
+    return c == c_;
+  }
+
+  char character() const {
+    return c_;
+  }
+
 private:
   char c_;
 };
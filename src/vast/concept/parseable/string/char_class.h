@@ -37,6 +37,10 @@ public:
     return true;
   }
 
+  bool test(char c) const {
+    return test_char(c, CharClass{});
+  }
+
 private:
 #define VAST_DEFINE_CHAR_TEST(klass, fun)                                      \
   static bool test_char(int c, klass##_class) {                                \
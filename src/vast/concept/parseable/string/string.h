@@ -42,6 +42,10 @@ public:
     return true;
   }
 
+  std::string const& str() const {
+    return str_;
+  }
+
 private:
   std::string str_;
 };
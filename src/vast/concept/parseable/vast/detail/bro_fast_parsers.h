@@ -0,0 +1,224 @@
+#ifndef VAST_CONCEPT_PARSEABLE_VAST_DETAIL_BRO_FAST_PARSERS_H
+#define VAST_CONCEPT_PARSEABLE_VAST_DETAIL_BRO_FAST_PARSERS_H
+
+#include <cstdint>
+#include <limits>
+
+#include "vast/address.h"
+#include "vast/concept/parseable/core/parser.h"
+#include "vast/concept/parseable/numeric/real.h"
+#include "vast/concept/parseable/vast/address.h"
+
+// This file contains hand-written parsers for the field types which dominate
+// Bro logs. Each parser accepts the same input and produces the same
+// attribute as its combinator-based counterpart, but processes the common
+// input forms with a single pass over the characters. For inputs outside
+// the fast path, the parsers defer to the generic version.
+
+namespace vast {
+namespace detail {
+
+inline int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/// Parses an unsigned decimal number, equivalent to `integral_parser<T>`.
+template <typename T, int MaxDigits = std::numeric_limits<T>::digits10 + 1>
+struct bro_unsigned_parser : parser<bro_unsigned_parser<T, MaxDigits>> {
+  using attribute = T;
+
+  template <typename Iterator, typename Attribute>
+  bool parse(Iterator& f, Iterator const& l, Attribute& a) const {
+    auto i = f;
+    T x = 0;
+    int digits = 0;
+    while (i != l) {
+      auto d = static_cast<unsigned>(*i) - '0';
+      if (d > 9)
+        break;
+      if (++digits > MaxDigits)
+        return false;
+      x = x * 10 + d;
+      ++i;
+    }
+    if (digits == 0)
+      return false;
+    a = x;
+    f = i;
+    return true;
+  }
+};
+
+/// Parses a floating point number with a mandatory dot, equivalent to
+/// `parsers::real`. Bro renders times and intervals with a fixed number of
+/// fractional digits, which this parser handles with integer arithmetic and
+/// a single division.
+struct bro_real_parser : parser<bro_real_parser> {
+  using attribute = double;
+
+  // Up to this many digits, accumulating in double precision yields the
+  // exact integer value, so that our results equal those of real_parser.
+  static constexpr int max_exact_digits = 15;
+
+  template <typename Iterator>
+  static int parse_digits(Iterator& f, Iterator const& l, uint64_t& x) {
+    int digits = 0;
+    while (f != l) {
+      auto d = static_cast<unsigned>(*f) - '0';
+      if (d > 9)
+        break;
+      x = x * 10 + d;
+      ++digits;
+      ++f;
+    }
+    return digits;
+  }
+
+  template <typename Iterator, typename Attribute>
+  bool parse(Iterator& f, Iterator const& l, Attribute& a) const {
+    static double const pow10[] = {1e0, 1e1, 1e2,  1e3,  1e4,  1e5,
+                                   1e6, 1e7, 1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15};
+    if (f == l)
+      return false;
+    auto i = f;
+    auto negative = *i == '-';
+    if (negative || *i == '+')
+      ++i;
+    uint64_t integral = 0;
+    auto integral_digits = parse_digits(i, l, integral);
+    if (i == l || *i != '.')
+      return false;
+    ++i;
+    uint64_t fractional = 0;
+    auto fractional_digits = parse_digits(i, l, fractional);
+    if (integral_digits == 0 && fractional_digits == 0)
+      return false;
+    if (integral_digits > max_exact_digits
+        || fractional_digits > max_exact_digits)
+      return parsers::real.parse(f, l, a);
+    auto x = static_cast<double>(integral)
+             + static_cast<double>(fractional) / pow10[fractional_digits];
+    a = negative ? -x : x;
+    f = i;
+    return true;
+  }
+};
+
+/// Parses an IPv4 or IPv6 address, equivalent to `parsers::addr`.
+struct bro_address_parser : parser<bro_address_parser> {
+  using attribute = address;
+
+  template <typename Iterator>
+  static bool parse_v4(Iterator& f, Iterator const& l, address& a) {
+    auto i = f;
+    uint32_t bytes = 0;
+    for (auto n = 0; n < 4; ++n) {
+      if (n > 0) {
+        if (i == l || *i != '.')
+          return false;
+        ++i;
+      }
+      unsigned octet = 0;
+      auto digits = 0;
+      while (i != l && digits < 3) {
+        auto d = static_cast<unsigned>(*i) - '0';
+        if (d > 9)
+          break;
+        octet = octet * 10 + d;
+        ++digits;
+        ++i;
+      }
+      if (digits == 0 || octet > 255)
+        return false;
+      if (i != l && static_cast<unsigned>(*i) - '0' <= 9)
+        return false;
+      bytes = (bytes << 8) | octet;
+    }
+    a = {&bytes, address::ipv4, address::host};
+    f = i;
+    return true;
+  }
+
+  // Handles addresses consisting of hex groups and at most one "::". We leave
+  // embedded IPv4 addresses and malformed input to the generic parser.
+  template <typename Iterator>
+  static bool parse_v6(Iterator& f, Iterator const& l, address& a) {
+    uint16_t groups[8];
+    auto n = 0;
+    auto gap = -1;
+    auto i = f;
+    if (i != l && *i == ':') {
+      if (++i == l || *i != ':')
+        return false;
+      ++i;
+      gap = 0;
+    }
+    while (n < 8 && i != l && hex_value(*i) >= 0) {
+      unsigned group = 0;
+      auto digits = 0;
+      int h;
+      while (i != l && digits < 4 && (h = hex_value(*i)) >= 0) {
+        group = (group << 4) | h;
+        ++digits;
+        ++i;
+      }
+      if (i != l && (*i == '.' || hex_value(*i) >= 0))
+        return false;
+      groups[n++] = group;
+      if (i == l || *i != ':')
+        break;
+      auto j = i + 1;
+      if (j != l && *j == ':') {
+        if (gap >= 0)
+          return false;
+        gap = n;
+        i = j + 1;
+      } else if (j != l && hex_value(*j) >= 0) {
+        i = j;
+      } else {
+        return false;
+      }
+    }
+    if (gap < 0 ? n != 8 : n > 7)
+      return false;
+    if (i != l && (*i == ':' || *i == '.' || hex_value(*i) >= 0))
+      return false;
+    uint16_t expanded[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    auto head = gap < 0 ? n : gap;
+    for (auto k = 0; k < head; ++k)
+      expanded[k] = groups[k];
+    for (auto k = head; k < n; ++k)
+      expanded[8 - n + k] = groups[k];
+    uint32_t words[4];
+    for (auto k = 0; k < 4; ++k)
+      words[k] = (uint32_t{expanded[2 * k]} << 16) | expanded[2 * k + 1];
+    a = {words, address::ipv6, address::host};
+    f = i;
+    return true;
+  }
+
+  template <typename Iterator>
+  bool parse(Iterator& f, Iterator const& l, address& a) const {
+    if (parse_v4(f, l, a) || parse_v6(f, l, a))
+      return true;
+    return parsers::addr.parse(f, l, a);
+  }
+
+  template <typename Iterator>
+  bool parse(Iterator& f, Iterator const& l, unused_type) const {
+    address a;
+    return parse(f, l, a);
+  }
+};
+
+} // namespace detail
+} // namespace vast
+
+#endif
@@ -8,6 +8,7 @@
 #include "vast/concept/parseable/string/any.h"
 #include "vast/concept/parseable/vast/address.h"
 #include "vast/concept/parseable/vast/subnet.h"
+#include "vast/concept/parseable/vast/detail/bro_fast_parsers.h"
 #include "vast/util/assert.h"
 #include "vast/util/string.h"
 
@@ -51,20 +52,20 @@ struct bro_parser
 
   bool operator()(type::count const&) const
   {
-    static auto p = parsers::u64 ->* [](count x) { return x; };
+    static auto p = bro_unsigned_parser<count>{} ->* [](count x) { return x; };
     return parse(p);
   }
 
   bool operator()(type::time_point const&) const
   {
-    static auto p = parsers::real
+    static auto p = bro_real_parser{}
       ->* [](real x) { return time::point{time::fractional(x)}; };
     return parse(p);
   }
 
   bool operator()(type::time_duration const&) const
   {
-    static auto p = parsers::real
+    static auto p = bro_real_parser{}
       ->* [](real x) { return time::duration{time::fractional(x)}; };
     return parse(p);
   }
@@ -85,7 +86,7 @@ struct bro_parser
 
   bool operator()(type::address const&) const
   {
-    static auto p = parsers::addr ->* [](address x) { return x; };
+    static auto p = bro_address_parser{} ->* [](address x) { return x; };
     return parse(p);
   }
 
@@ -97,7 +98,7 @@ struct bro_parser
 
   bool operator()(type::port const&) const
   {
-    static auto p = parsers::u16
+    static auto p = bro_unsigned_parser<uint16_t>{}
       ->* [](uint16_t x) { return port{x, port::unknown}; };
     return parse(p);
   }
@@ -131,16 +132,16 @@ struct bro_parser_factory {
   }
 
   result_type operator()(type::count const&) const {
-    return parsers::u64 ->* [](count x) { return x; };
+    return bro_unsigned_parser<count>{} ->* [](count x) { return x; };
   }
 
   result_type operator()(type::time_point const&) const {
-    return parsers::real
+    return bro_real_parser{}
       ->* [](real x) { return time::point{time::fractional(x)}; };
   }
 
   result_type operator()(type::time_duration const&) const {
-    return parsers::real
+    return bro_real_parser{}
       ->* [](real x) { return time::duration{time::fractional(x)}; };
   }
 
@@ -163,7 +164,7 @@ struct bro_parser_factory {
   }
 
   result_type operator()(type::address const&) const {
-    return parsers::addr ->* [](address x) { return x; };
+    return bro_address_parser{} ->* [](address x) { return x; };
   }
 
   result_type operator()(type::subnet const&) const {
@@ -171,7 +172,8 @@ struct bro_parser_factory {
   }
 
   result_type operator()(type::port const&) const {
-    return parsers::u16 ->* [](uint16_t x) { return port{x, port::unknown}; };
+    return bro_unsigned_parser<uint16_t>{}
+      ->* [](uint16_t x) { return port{x, port::unknown}; };
   }
 
   result_type operator()(type::set const& t) const {
@@ -47,7 +47,10 @@ struct json_printer : printer<json_printer<TreePolicy, Indent>> {
 
   template <typename Iterator>
   struct print_visitor {
-    print_visitor(Iterator& out) : out_{out} {
+    /// Constructs a visitor printing into an output iterator.
+    /// @param out The iterator to print into.
+    /// @param depth The nesting level of the printed values.
+    print_visitor(Iterator& out, int depth = 0) : out_{out}, depth_{depth} {
     }
 
     bool operator()(none const&) {
@@ -73,58 +76,80 @@ struct json_printer : printer<json_printer<TreePolicy, Indent>> {
     }
 
     bool operator()(json::array const& a) {
+      return print_array(a, [&](auto& x) { return visit(*this, x); });
+    }
+
+    bool operator()(json::object const& o) {
+      return print_object(o, [&](auto& x) { return visit(*this, x); });
+    }
+
+    /// Prints a sequence as JSON array without converting its elements into
+    /// JSON first.
+    /// @param xs The sequence to print.
+    /// @param f The function printing a single element of *xs*.
+    /// @returns `true` on success.
+    template <typename Container, typename F>
+    bool print_array(Container const& xs, F f) {
       using namespace printers;
       if (!any.print(out_, '['))
         return false;
-      if (!a.empty() && tree) {
+      if (!xs.empty() && tree) {
         ++depth_;
-        any.print(out_, '\n');
+        if (!any.print(out_, '\n'))
+          return false;
       }
-      auto begin = a.begin();
-      auto end = a.end();
+      auto begin = xs.begin();
+      auto end = xs.end();
       while (begin != end) {
         indent();
-        if (!visit(*this, *begin))
+        if (!f(*begin))
           return false;
-        ;
         ++begin;
         if (begin != end)
           if (!str.print(out_, tree ? ",\n" : ", "))
             return false;
       }
-      if (!a.empty() && tree) {
+      if (!xs.empty() && tree) {
         --depth_;
-        any.print(out_, '\n');
+        if (!any.print(out_, '\n'))
+          return false;
         indent();
       }
       return any.print(out_, ']');
     }
 
-    bool operator()(json::object const& o) {
+    /// Prints a sequence of key-value pairs as JSON object without converting
+    /// the values into JSON first.
+    /// @param xs The sequence to print, whose elements have the key (or a
+    ///           pointer to it) as `first` and the value as `second`.
+    /// @param f The function printing the value of a single element of *xs*.
+    /// @returns `true` on success.
+    template <typename Container, typename F>
+    bool print_object(Container const& xs, F f) {
       using namespace printers;
       if (!any.print(out_, '{'))
         return false;
-      if (!o.empty() && tree) {
+      if (!xs.empty() && tree) {
         ++depth_;
         if (!any.print(out_, '\n'))
           return false;
       }
-      auto begin = o.begin();
-      auto end = o.end();
+      auto begin = xs.begin();
+      auto end = xs.end();
       while (begin != end) {
         indent();
-        if (!(*this)(begin->first))
+        if (!(*this)(key(begin->first)))
           return false;
         if (!str.print(out_, ": "))
           return false;
-        if (!visit(*this, begin->second))
+        if (!f(begin->second))
           return false;
         ++begin;
         if (begin != end)
           if (!str.print(out_, tree ? ",\n" : ", "))
             return false;
       }
-      if (!o.empty() && tree) {
+      if (!xs.empty() && tree) {
         --depth_;
         if (!any.print(out_, '\n'))
           return false;
@@ -139,6 +164,14 @@ struct json_printer : printer<json_printer<TreePolicy, Indent>> {
           printers::any.print(out_, ' '); // FIXME: add boolean return value.
     }
 
+    static std::string const& key(std::string const& x) {
+      return x;
+    }
+
+    static std::string const& key(std::string const* x) {
+      return *x;
+    }
+
     Iterator& out_;
     int depth_ = 0;
   };
@@ -128,8 +128,52 @@ struct in_visitor {
   }
 };
 
+// Computes the heap memory of data, beyond the size of the data instance.
+struct footprint_visitor {
+  template <typename T>
+  size_t operator()(T const&) const {
+    return 0;
+  }
+
+  size_t operator()(std::string const& x) const {
+    return x.size();
+  }
+
+  size_t operator()(vector const& xs) const {
+    return elements(xs);
+  }
+
+  size_t operator()(set const& xs) const {
+    return elements(xs);
+  }
+
+  size_t operator()(record const& xs) const {
+    return elements(xs);
+  }
+
+  size_t operator()(table const& xs) const {
+    // Each map node holds a key, a value, and the pointers of a tree node.
+    auto result = xs.size() * (2 * sizeof(data) + 4 * sizeof(void*));
+    for (auto& x : xs)
+      result += visit(*this, x.first) + visit(*this, x.second);
+    return result;
+  }
+
+  template <typename Container>
+  size_t elements(Container const& xs) const {
+    auto result = xs.size() * sizeof(data);
+    for (auto& x : xs)
+      result += visit(*this, x);
+    return result;
+  }
+};
+
 } // namespace <anonymous>
 
+size_t footprint(data const& d) {
+  return sizeof(data) + visit(footprint_visitor{}, d);
+}
+
 bool data::evaluate(data const& lhs, relational_operator op, data const& rhs) {
   switch (op) {
     default:
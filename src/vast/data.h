@@ -271,6 +271,12 @@ private:
   variant_type data_;
 };
 
+/// Estimates the memory a data instance occupies.
+/// @param d The data to inspect.
+/// @returns The estimated number of bytes *d* occupies in memory, including
+///          all nested data.
+size_t footprint(data const& d);
+
 } // namespace vast
 
 #endif
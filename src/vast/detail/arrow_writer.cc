@@ -0,0 +1,750 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "vast/data.h"
+#include "vast/event.h"
+#include "vast/concept/printable/to_string.h"
+#include "vast/concept/printable/vast/pattern.h"
+#include "vast/detail/arrow_writer.h"
+#include "vast/util/assert.h"
+
+namespace vast {
+namespace detail {
+
+namespace {
+
+// Constants from the Arrow FlatBuffers schemas (Message.fbs, Schema.fbs).
+constexpr int16_t metadata_version_v5 = 4;
+constexpr uint8_t header_schema = 1;
+constexpr uint8_t header_record_batch = 3;
+constexpr int16_t endianness_little = 0;
+constexpr int16_t precision_double = 2;
+constexpr int16_t time_unit_nanosecond = 3;
+
+enum arrow_type : uint8_t {
+  arrow_null = 1,
+  arrow_int = 2,
+  arrow_floating_point = 3,
+  arrow_utf8 = 5,
+  arrow_bool = 6,
+  arrow_timestamp = 10,
+  arrow_list = 12,
+  arrow_struct = 13,
+  arrow_fixed_size_binary = 15,
+  arrow_map = 17,
+  arrow_duration = 18
+};
+
+// Appends an integral value in little-endian byte order.
+template <typename T>
+void put(std::string& buf, T x) {
+  auto u = static_cast<std::make_unsigned_t<T>>(x);
+  for (size_t i = 0; i < sizeof(T); ++i)
+    buf.push_back(static_cast<char>((u >> (8 * i)) & 0xff));
+}
+
+void put(std::string& buf, double x) {
+  uint64_t u;
+  std::memcpy(&u, &x, sizeof(u));
+  put(buf, u);
+}
+
+// Overwrites *size* bytes at a given position with a little-endian value.
+void put_at(std::string& buf, size_t pos, uint64_t x, size_t size) {
+  for (size_t i = 0; i < size; ++i)
+    buf[pos + i] = static_cast<char>((x >> (8 * i)) & 0xff);
+}
+
+void pad(std::string& buf, size_t alignment) {
+  while (buf.size() % alignment != 0)
+    buf.push_back('\0');
+}
+
+void set_bit(std::string& bits, size_t i, bool x) {
+  if (i % 8 == 0)
+    bits.push_back('\0');
+  if (x)
+    bits[i / 8] |= static_cast<char>(1 << (i % 8));
+}
+
+// Writes a FlatBuffer front to back. A table precedes the tables, vectors,
+// and strings it references, so that all offsets point forward as the format
+// requires.
+class flatbuffer {
+public:
+  flatbuffer() : buf_(4, '\0') {
+    // The first four bytes hold the offset to the root table.
+  }
+
+  std::string const& bytes() const {
+    return buf_;
+  }
+
+  std::string& bytes() {
+    return buf_;
+  }
+
+  void root(size_t table) {
+    refer(0, table);
+  }
+
+  // Points the offset at *slot* to the object at *target*.
+  void refer(size_t slot, size_t target) {
+    VAST_ASSERT(target > slot);
+    put_at(buf_, slot, target - slot, 4);
+  }
+
+  size_t string(std::string const& str) {
+    pad(buf_, 4);
+    auto pos = buf_.size();
+    put(buf_, static_cast<uint32_t>(str.size()));
+    buf_ += str;
+    buf_.push_back('\0');
+    return pos;
+  }
+
+  // Appends a zeroed vector of *n* elements of *size* bytes each, aligned at
+  // *alignment* bytes. The elements begin 4 bytes after the returned position.
+  size_t vector(size_t n, size_t size, size_t alignment) {
+    pad(buf_, 4);
+    while ((buf_.size() + 4) % alignment != 0)
+      buf_.push_back('\0');
+    auto pos = buf_.size();
+    put(buf_, static_cast<uint32_t>(n));
+    buf_.resize(buf_.size() + n * size);
+    return pos;
+  }
+
+private:
+  std::string buf_;
+};
+
+// Lays out a FlatBuffers table: the vtable, followed by the table with its
+// fields ordered by decreasing size.
+class table_builder {
+public:
+  template <typename T>
+  table_builder& add(uint16_t id, T x) {
+    fields_.push_back({id, sizeof(T), static_cast<uint64_t>(x), 0});
+    return *this;
+  }
+
+  // Adds an offset to be set with flatbuffer::refer after finishing.
+  table_builder& add_offset(uint16_t id) {
+    fields_.push_back({id, 4, 0, 0});
+    return *this;
+  }
+
+  size_t finish(flatbuffer& fb) {
+    auto& buf = fb.bytes();
+    std::stable_sort(fields_.begin(), fields_.end(),
+                     [](auto& x, auto& y) { return x.size > y.size; });
+    size_t slots = 0;
+    for (auto& f : fields_)
+      slots = std::max(slots, size_t{f.id} + 1u);
+    std::vector<uint16_t> offsets(slots, 0);
+    size_t size = 4; // The offset to the vtable comes first.
+    for (auto& f : fields_) {
+      size = (size + f.size - 1) / f.size * f.size;
+      f.pos = size;
+      offsets[f.id] = static_cast<uint16_t>(size);
+      size += f.size;
+    }
+    pad(buf, 2);
+    auto vtable = buf.size();
+    put(buf, static_cast<uint16_t>(4 + 2 * slots));
+    put(buf, static_cast<uint16_t>(size));
+    for (auto o : offsets)
+      put(buf, o);
+    pad(buf, 8);
+    auto pos = buf.size();
+    put(buf, static_cast<int32_t>(pos - vtable));
+    buf.resize(pos + size);
+    for (auto& f : fields_) {
+      f.pos += pos;
+      put_at(buf, f.pos, f.value, f.size);
+    }
+    return pos;
+  }
+
+  size_t slot(uint16_t id) const {
+    auto i = std::find_if(fields_.begin(), fields_.end(),
+                          [=](auto& f) { return f.id == id; });
+    VAST_ASSERT(i != fields_.end());
+    return i->pos;
+  }
+
+private:
+  struct field {
+    uint16_t id;
+    size_t size;
+    uint64_t value;
+    size_t pos;
+  };
+
+  std::vector<field> fields_;
+};
+
+using pairs = std::vector<std::pair<int64_t, int64_t>>;
+
+// Appends a buffer to a record batch body, padded to 8 bytes.
+void add_buffer(pairs& buffers, std::string& body, std::string const& data) {
+  buffers.emplace_back(body.size(), data.size());
+  body += data;
+  pad(body, 8);
+}
+
+size_t write_pairs(flatbuffer& fb, pairs const& xs) {
+  auto pos = fb.vector(xs.size(), 16, 8);
+  for (size_t i = 0; i < xs.size(); ++i) {
+    put_at(fb.bytes(), pos + 4 + 16 * i, xs[i].first, 8);
+    put_at(fb.bytes(), pos + 12 + 16 * i, xs[i].second, 8);
+  }
+  return pos;
+}
+
+// Appends an encapsulated IPC message.
+void write_message(std::string& out, std::string const& metadata,
+                   std::string const& body) {
+  auto size = (metadata.size() + 7) / 8 * 8;
+  put(out, uint32_t{0xffffffff});
+  put(out, static_cast<int32_t>(size));
+  out += metadata;
+  out.append(size - metadata.size(), '\0');
+  out += body;
+}
+
+} // namespace <anonymous>
+
+// A column of a record batch in Arrow memory layout.
+struct arrow_writer::column {
+  enum class kind {
+    null,
+    boolean,
+    integer,
+    count,
+    real,
+    time_point,
+    time_duration,
+    string,
+    enumeration,
+    address,
+    uint8,
+    uint16,
+    subnet,
+    port,
+    list,
+    map,
+    structure
+  };
+
+  column(std::string n, kind k, bool null = true)
+    : name{std::move(n)}, tag{k}, nullable{null} {
+    clear();
+  }
+
+  // Creates the column for a VAST type.
+  static std::unique_ptr<column> make(std::string name, type const& t) {
+    auto c = [&](kind k) {
+      return std::make_unique<column>(std::move(name), k);
+    };
+    switch (which(t)) {
+      default:
+        return c(kind::null);
+      case type::tag::boolean:
+        return c(kind::boolean);
+      case type::tag::integer:
+        return c(kind::integer);
+      case type::tag::count:
+        return c(kind::count);
+      case type::tag::real:
+        return c(kind::real);
+      case type::tag::time_point:
+        return c(kind::time_point);
+      case type::tag::time_duration:
+        return c(kind::time_duration);
+      case type::tag::string:
+      case type::tag::pattern:
+        return c(kind::string);
+      case type::tag::enumeration: {
+        auto result = c(kind::enumeration);
+        result->enum_fields = get<type::enumeration>(t)->fields();
+        return result;
+      }
+      case type::tag::address:
+        return c(kind::address);
+      case type::tag::subnet: {
+        auto result = c(kind::subnet);
+        result->add(std::make_unique<column>("network", kind::address));
+        result->add(std::make_unique<column>("length", kind::uint8));
+        return result;
+      }
+      case type::tag::port: {
+        auto result = c(kind::port);
+        result->add(std::make_unique<column>("number", kind::uint16));
+        result->add(std::make_unique<column>("type", kind::uint8));
+        return result;
+      }
+      case type::tag::vector: {
+        auto result = c(kind::list);
+        result->add(make("item", get<type::vector>(t)->elem()));
+        return result;
+      }
+      case type::tag::set: {
+        auto result = c(kind::list);
+        result->add(make("item", get<type::set>(t)->elem()));
+        return result;
+      }
+      case type::tag::table: {
+        auto tt = get<type::table>(t);
+        auto entries = std::make_unique<column>("entries", kind::structure,
+                                                false);
+        entries->add(make("key", tt->key()));
+        entries->children[0]->nullable = false;
+        entries->add(make("value", tt->value()));
+        auto result = c(kind::map);
+        result->add(std::move(entries));
+        return result;
+      }
+      case type::tag::record: {
+        auto result = c(kind::structure);
+        for (auto& f : get<type::record>(t)->fields())
+          result->add(make(f.name, f.type));
+        return result;
+      }
+      case type::tag::alias:
+        return make(std::move(name), get<type::alias>(t)->type());
+    }
+  }
+
+  void add(std::unique_ptr<column> child) {
+    children.push_back(std::move(child));
+  }
+
+  void clear() {
+    length = 0;
+    null_count = 0;
+    validity.clear();
+    values.clear();
+    offsets.assign(1, 0);
+    for (auto& child : children)
+      child->clear();
+  }
+
+  // Marks the next slot as valid or null.
+  void mark(bool valid) {
+    set_bit(validity, length++, valid);
+    if (!valid)
+      ++null_count;
+  }
+
+  template <typename T>
+  void append_fixed(T x) {
+    put(values, x);
+    mark(true);
+  }
+
+  void append_string(std::string const& str) {
+    values += str;
+    VAST_ASSERT(values.size() <= std::numeric_limits<int32_t>::max());
+    offsets.push_back(static_cast<int32_t>(values.size()));
+    mark(true);
+  }
+
+  void append_null() {
+    switch (tag) {
+      default:
+        values.append(width(), '\0');
+        break;
+      case kind::null:
+        break;
+      case kind::boolean:
+        set_bit(values, length, false);
+        break;
+      case kind::string:
+      case kind::enumeration:
+      case kind::list:
+      case kind::map:
+        offsets.push_back(offsets.back());
+        break;
+      case kind::subnet:
+      case kind::port:
+      case kind::structure:
+        for (auto& child : children)
+          child->append_null();
+        break;
+    }
+    mark(false);
+  }
+
+  void append(data const& d) {
+    if (!append_value(d))
+      append_null();
+  }
+
+  // Appends a valid value if the data matches the column.
+  bool append_value(data const& d) {
+    switch (tag) {
+      default:
+        return false;
+      case kind::boolean:
+        if (auto x = get<boolean>(d)) {
+          set_bit(values, length, *x);
+          mark(true);
+          return true;
+        }
+        return false;
+      case kind::integer:
+        if (auto x = get<integer>(d)) {
+          append_fixed(*x);
+          return true;
+        }
+        return false;
+      case kind::count:
+        if (auto x = get<count>(d)) {
+          append_fixed(*x);
+          return true;
+        }
+        return false;
+      case kind::real:
+        if (auto x = get<real>(d)) {
+          append_fixed(*x);
+          return true;
+        }
+        return false;
+      case kind::time_point:
+        if (auto x = get<time::point>(d)) {
+          append_fixed(int64_t{x->time_since_epoch().count()});
+          return true;
+        }
+        return false;
+      case kind::time_duration:
+        if (auto x = get<time::duration>(d)) {
+          append_fixed(int64_t{x->count()});
+          return true;
+        }
+        return false;
+      case kind::string:
+        if (auto x = get<std::string>(d)) {
+          append_string(*x);
+          return true;
+        }
+        if (auto x = get<pattern>(d)) {
+          append_string(to_string(*x));
+          return true;
+        }
+        return false;
+      case kind::enumeration:
+        if (auto x = get<enumeration>(d)) {
+          if (*x >= enum_fields.size())
+            return false;
+          append_string(enum_fields[*x]);
+          return true;
+        }
+        return false;
+      case kind::address:
+        if (auto x = get<address>(d)) {
+          append_address(*x);
+          return true;
+        }
+        return false;
+      case kind::subnet:
+        if (auto x = get<subnet>(d)) {
+          children[0]->append_address(x->network());
+          children[1]->append_fixed(uint8_t{x->length()});
+          mark(true);
+          return true;
+        }
+        return false;
+      case kind::port:
+        if (auto x = get<port>(d)) {
+          children[0]->append_fixed(uint16_t{x->number()});
+          children[1]->append_fixed(static_cast<uint8_t>(x->type()));
+          mark(true);
+          return true;
+        }
+        return false;
+      case kind::list:
+        if (auto x = get<vector>(d)) {
+          append_list(*x);
+          return true;
+        }
+        if (auto x = get<set>(d)) {
+          append_list(*x);
+          return true;
+        }
+        return false;
+      case kind::map:
+        if (auto x = get<table>(d)) {
+          auto& entries = *children[0];
+          for (auto& p : *x) {
+            entries.children[0]->append(p.first);
+            entries.children[1]->append(p.second);
+            entries.mark(true);
+          }
+          offsets.push_back(static_cast<int32_t>(entries.length));
+          mark(true);
+          return true;
+        }
+        return false;
+      case kind::structure:
+        if (auto x = get<record>(d)) {
+          for (size_t i = 0; i < children.size(); ++i)
+            if (i < x->size())
+              children[i]->append((*x)[i]);
+            else
+              children[i]->append_null();
+          mark(true);
+          return true;
+        }
+        return false;
+    }
+  }
+
+  void append_address(address const& a) {
+    values.append(reinterpret_cast<char const*>(a.data().data()), 16);
+    mark(true);
+  }
+
+  template <typename Container>
+  void append_list(Container const& xs) {
+    for (auto& x : xs)
+      children[0]->append(x);
+    offsets.push_back(static_cast<int32_t>(children[0]->length));
+    mark(true);
+  }
+
+  // The number of bytes per value of fixed-width columns.
+  size_t width() const {
+    switch (tag) {
+      default:
+        return 0;
+      case kind::uint8:
+        return 1;
+      case kind::uint16:
+        return 2;
+      case kind::integer:
+      case kind::count:
+      case kind::real:
+      case kind::time_point:
+      case kind::time_duration:
+        return 8;
+      case kind::address:
+        return 16;
+    }
+  }
+
+  size_t write_field(flatbuffer& fb) const {
+    table_builder f;
+    f.add_offset(0)
+     .add(1, nullable)
+     .add(2, static_cast<uint8_t>(arrow_type_id()))
+     .add_offset(3)
+     .add_offset(5);
+    auto pos = f.finish(fb);
+    fb.refer(f.slot(0), fb.string(name));
+    fb.refer(f.slot(3), write_type(fb));
+    fb.refer(f.slot(5), write_children(fb));
+    return pos;
+  }
+
+  size_t write_children(flatbuffer& fb) const {
+    auto pos = fb.vector(children.size(), 4, 4);
+    for (size_t i = 0; i < children.size(); ++i)
+      fb.refer(pos + 4 + 4 * i, children[i]->write_field(fb));
+    return pos;
+  }
+
+  arrow_type arrow_type_id() const {
+    switch (tag) {
+      default:
+        return arrow_null;
+      case kind::boolean:
+        return arrow_bool;
+      case kind::integer:
+      case kind::count:
+      case kind::uint8:
+      case kind::uint16:
+        return arrow_int;
+      case kind::real:
+        return arrow_floating_point;
+      case kind::time_point:
+        return arrow_timestamp;
+      case kind::time_duration:
+        return arrow_duration;
+      case kind::string:
+      case kind::enumeration:
+        return arrow_utf8;
+      case kind::address:
+        return arrow_fixed_size_binary;
+      case kind::subnet:
+      case kind::port:
+      case kind::structure:
+        return arrow_struct;
+      case kind::list:
+        return arrow_list;
+      case kind::map:
+        return arrow_map;
+    }
+  }
+
+  size_t write_type(flatbuffer& fb) const {
+    table_builder t;
+    switch (tag) {
+      default:
+        break;
+      case kind::integer:
+        t.add(0, int32_t{64}).add(1, true);
+        break;
+      case kind::count:
+      case kind::uint8:
+      case kind::uint16:
+        t.add(0, static_cast<int32_t>(8 * width())).add(1, false);
+        break;
+      case kind::real:
+        t.add(0, precision_double);
+        break;
+      case kind::time_point:
+      case kind::time_duration:
+        t.add(0, time_unit_nanosecond);
+        break;
+      case kind::address:
+        t.add(0, int32_t{16});
+        break;
+      case kind::map:
+        t.add(0, true); // Tables iterate in key order.
+        break;
+    }
+    return t.finish(fb);
+  }
+
+  // Adds the field nodes and buffers of this column and its children in
+  // depth-first order.
+  void collect(pairs& nodes, pairs& buffers, std::string& body) const {
+    nodes.emplace_back(length, null_count);
+    if (tag == kind::null)
+      return;
+    add_buffer(buffers, body, null_count > 0 ? validity : std::string{});
+    switch (tag) {
+      default:
+        add_buffer(buffers, body, values);
+        break;
+      case kind::subnet:
+      case kind::port:
+      case kind::structure:
+        break;
+      case kind::string:
+      case kind::enumeration:
+      case kind::list:
+      case kind::map: {
+        std::string bytes;
+        bytes.reserve(offsets.size() * sizeof(int32_t));
+        for (auto o : offsets)
+          put(bytes, o);
+        add_buffer(buffers, body, bytes);
+        if (tag == kind::string || tag == kind::enumeration)
+          add_buffer(buffers, body, values);
+        break;
+      }
+    }
+    for (auto& child : children)
+      child->collect(nodes, buffers, body);
+  }
+
+  std::string name;
+  kind tag;
+  bool nullable;
+  std::vector<std::string> enum_fields;
+  std::vector<std::unique_ptr<column>> children;
+  size_t length;
+  size_t null_count;
+  std::string validity;
+  std::string values;
+  std::vector<int32_t> offsets;
+};
+
+arrow_writer::arrow_writer(type const& t)
+  : root_{std::make_unique<column>("", column::kind::structure, false)} {
+  using kind = column::kind;
+  root_->add(std::make_unique<column>("event_id", kind::count, false));
+  root_->add(std::make_unique<column>("event_timestamp", kind::time_point,
+                                      false));
+  if (auto r = get<type::record>(t))
+    for (auto& f : r->fields())
+      root_->add(column::make(f.name, f.type));
+  else
+    root_->add(column::make("value", t));
+}
+
+arrow_writer::~arrow_writer() {
+}
+
+void arrow_writer::write_schema(std::string& out) const {
+  flatbuffer fb;
+  table_builder message;
+  message.add(0, metadata_version_v5)
+         .add(1, header_schema)
+         .add_offset(2)
+         .add(3, int64_t{0});
+  fb.root(message.finish(fb));
+  table_builder schema;
+  schema.add(0, endianness_little).add_offset(1);
+  fb.refer(message.slot(2), schema.finish(fb));
+  fb.refer(schema.slot(1), root_->write_children(fb));
+  write_message(out, fb.bytes(), {});
+}
+
+void arrow_writer::add(event const& e) {
+  auto& columns = root_->children;
+  columns[0]->append_fixed(uint64_t{e.id()});
+  columns[1]->append_fixed(int64_t{e.timestamp().time_since_epoch().count()});
+  if (is<type::record>(e.type())) {
+    auto r = get<record>(e);
+    for (size_t i = 2; i < columns.size(); ++i)
+      if (r && i - 2 < r->size())
+        columns[i]->append((*r)[i - 2]);
+      else
+        columns[i]->append_null();
+  } else {
+    columns[2]->append(e.data());
+  }
+  root_->mark(true);
+}
+
+size_t arrow_writer::rows() const {
+  return root_->length;
+}
+
+void arrow_writer::write_batch(std::string& out) {
+  pairs nodes;
+  pairs buffers;
+  std::string body;
+  for (auto& c : root_->children)
+    c->collect(nodes, buffers, body);
+  flatbuffer fb;
+  table_builder message;
+  message.add(0, metadata_version_v5)
+         .add(1, header_record_batch)
+         .add_offset(2)
+         .add(3, static_cast<int64_t>(body.size()));
+  fb.root(message.finish(fb));
+  table_builder batch;
+  batch.add(0, static_cast<int64_t>(root_->length))
+       .add_offset(1)
+       .add_offset(2);
+  fb.refer(message.slot(2), batch.finish(fb));
+  fb.refer(batch.slot(1), write_pairs(fb, nodes));
+  fb.refer(batch.slot(2), write_pairs(fb, buffers));
+  write_message(out, fb.bytes(), body);
+  root_->clear();
+}
+
+void arrow_writer::write_eos(std::string& out) {
+  put(out, uint32_t{0xffffffff});
+  put(out, int32_t{0});
+}
+
+} // namespace detail
+} // namespace vast
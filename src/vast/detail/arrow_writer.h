@@ -0,0 +1,73 @@
+#ifndef VAST_DETAIL_ARROW_WRITER_H
+#define VAST_DETAIL_ARROW_WRITER_H
+
+#include <memory>
+#include <string>
+
+#include "vast/type.h"
+
+namespace vast {
+
+class event;
+
+namespace detail {
+
+/// Encodes events of a single type as an [Arrow IPC
+/// stream](https://arrow.apache.org/docs/format/Columnar.html). The stream
+/// begins with a schema message, continues with one record batch message per
+/// call to ::write_batch, and ends with an end-of-stream marker.
+///
+/// Each event becomes a row with the columns `event_id` (uint64),
+/// `event_timestamp` (nanosecond timestamp), and one column per field of the
+/// event's record type, or a single column `value` for other types. VAST types
+/// map to Arrow types as follows:
+///
+///   - *bool*, *int*, *count*, *real*: boolean, int64, uint64, float64
+///   - *time* and *interval*: nanosecond timestamp and duration
+///   - *string*, *pattern*, *enum*: UTF-8 string
+///   - *addr*: 16-byte fixed-size binary in IPv6 notation
+///   - *subnet*: struct of *network* (*addr*) and *length* (uint8)
+///   - *port*: struct of *number* (uint16) and *type* (uint8)
+///   - *vector* and *set*: list
+///   - *table*: map
+///   - *record*: struct
+class arrow_writer {
+public:
+  /// Constructs an Arrow writer for events of a given type.
+  /// @param t The type of the events to encode.
+  explicit arrow_writer(type const& t);
+
+  ~arrow_writer();
+
+  /// Appends the schema message to a buffer.
+  /// @param out The buffer to append to.
+  void write_schema(std::string& out) const;
+
+  /// Adds an event to the current record batch.
+  /// @param e The event to add.
+  /// @pre `e.type() == t` where *t* is the type given at construction.
+  void add(event const& e);
+
+  /// Retrieves the number of events in the current record batch.
+  /// @returns The number of events added since the last record batch.
+  size_t rows() const;
+
+  /// Appends the current record batch as a message to a buffer and starts a
+  /// new record batch.
+  /// @param out The buffer to append to.
+  void write_batch(std::string& out);
+
+  /// Appends the end-of-stream marker to a buffer.
+  /// @param out The buffer to append to.
+  static void write_eos(std::string& out);
+
+private:
+  struct column;
+
+  std::unique_ptr<column> root_;
+};
+
+} // namespace detail
+} // namespace vast
+
+#endif
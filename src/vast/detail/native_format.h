@@ -0,0 +1,56 @@
+#ifndef VAST_DETAIL_NATIVE_FORMAT_H
+#define VAST_DETAIL_NATIVE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vast {
+namespace detail {
+
+/// Constants of VAST's native binary format, which the *native* sink writes
+/// and the *native* source reads. A file consists of a header followed by a
+/// sequence of frames:
+///
+///     file   := magic version frame*
+///     magic  := "VAST"
+///     frame  := kind size payload
+///
+/// The *version*, *kind*, and *size* fields are little-endian integers of 4,
+/// 1, and 4 bytes. A schema frame holds a serialized ::schema with the types
+/// of the following chunks that did not appear in an earlier schema frame. A
+/// chunk frame holds a serialized ::chunk.
+namespace native_format {
+
+constexpr char magic[] = {'V', 'A', 'S', 'T'};
+constexpr uint32_t version = 1;
+constexpr size_t header_size = sizeof(magic) + sizeof(version);
+constexpr size_t frame_header_size = 5;
+
+enum frame_kind : uint8_t {
+  schema_frame = 0,
+  chunk_frame = 1
+};
+
+/// Encodes a 32-bit integer in little-endian byte order.
+/// @param x The value to encode.
+/// @param out The 4 bytes to write into.
+inline void encode(uint32_t x, uint8_t* out) {
+  for (auto i = 0; i < 4; ++i)
+    out[i] = static_cast<uint8_t>(x >> (8 * i));
+}
+
+/// Decodes a little-endian 32-bit integer.
+/// @param in The 4 bytes to read from.
+/// @returns The decoded value.
+inline uint32_t decode(uint8_t const* in) {
+  uint32_t x = 0;
+  for (auto i = 0; i < 4; ++i)
+    x |= uint32_t{in[i]} << (8 * i);
+  return x;
+}
+
+} // namespace native_format
+} // namespace detail
+} // namespace vast
+
+#endif
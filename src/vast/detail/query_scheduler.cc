@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <iterator>
+
+#include "vast/detail/query_scheduler.h"
+#include "vast/util/assert.h"
+
+namespace vast {
+namespace detail {
+
+query_scheduler::query_scheduler(size_t max_inflight)
+  : max_inflight_{max_inflight} {
+  VAST_ASSERT(max_inflight_ > 0);
+}
+
+void query_scheduler::add(expression const& expr, priority p) {
+  auto i = queries_.find(expr);
+  if (i == queries_.end()) {
+    queries_[expr].prio = p;
+    rings_[p].push_back(expr);
+  } else if (i->second.prio < p) {
+    auto& ring = rings_[i->second.prio];
+    ring.erase(std::find(ring.begin(), ring.end(), expr));
+    rings_[p].push_back(expr);
+    i->second.prio = p;
+  }
+}
+
+void query_scheduler::enqueue(expression const& expr, uuid const& part) {
+  auto q = queries_.find(expr);
+  VAST_ASSERT(q != queries_.end());
+  auto& pending = q->second.pending;
+  if (std::find(pending.begin(), pending.end(), part) == pending.end())
+    pending.push_back(part);
+}
+
+void query_scheduler::dispatch(expression const& expr, uuid const& part) {
+  auto q = queries_.find(expr);
+  VAST_ASSERT(q != queries_.end());
+  if (running_[part].insert(expr).second)
+    ++q->second.inflight;
+}
+
+optional<query_scheduler::selection>
+query_scheduler::next(std::function<bool(uuid const&)> const& admit) {
+  for (auto p = num_priorities; p > 0; --p) {
+    auto& ring = rings_[p - 1];
+    for (auto n = ring.size(); n > 0; --n) {
+      // Rotate the ring so that the next call begins with the next query.
+      ring.splice(ring.end(), ring, ring.begin());
+      auto& q = queries_[ring.back()];
+      if (q.pending.empty() || q.inflight >= max_inflight_)
+        continue;
+      if (admit && !admit(q.pending.front())) {
+        // Undo the rotation so that this query comes first next time.
+        ring.splice(ring.begin(), ring, std::prev(ring.end()));
+        return {};
+      }
+      // Every query waiting for the same partition joins the selection, which
+      // turns multiple scans into a single one.
+      selection result{q.pending.front(), {}};
+      auto& running = running_[result.first];
+      for (auto& pair : queries_) {
+        auto& pending = pair.second.pending;
+        auto i = std::find(pending.begin(), pending.end(), result.first);
+        if (i == pending.end())
+          continue;
+        pending.erase(i);
+        if (running.insert(pair.first).second)
+          ++pair.second.inflight;
+        result.second.push_back(pair.first);
+      }
+      return result;
+    }
+  }
+  return {};
+}
+
+std::vector<uuid> query_scheduler::peek(size_t n) const {
+  std::vector<uuid> result;
+  for (auto p = num_priorities; p > 0 && result.size() < n; --p) {
+    auto& ring = rings_[p - 1];
+    // Walk the pending partitions breadth-first, which mirrors the
+    // round-robin order of ::next.
+    for (size_t depth = 0; result.size() < n; ++depth) {
+      auto exhausted = true;
+      for (auto& expr : ring) {
+        auto& pending = queries_.find(expr)->second.pending;
+        if (depth >= pending.size())
+          continue;
+        exhausted = false;
+        auto& part = pending[depth];
+        if (std::find(result.begin(), result.end(), part) == result.end())
+          result.push_back(part);
+        if (result.size() == n)
+          break;
+      }
+      if (exhausted)
+        break;
+    }
+  }
+  return result;
+}
+
+bool query_scheduler::complete(expression const& expr, uuid const& part) {
+  auto r = running_.find(part);
+  if (r == running_.end())
+    return true;
+  if (r->second.erase(expr) > 0) {
+    auto q = queries_.find(expr);
+    VAST_ASSERT(q != queries_.end());
+    VAST_ASSERT(q->second.inflight > 0);
+    --q->second.inflight;
+    erase_if_idle(q);
+  }
+  if (!r->second.empty())
+    return false;
+  running_.erase(r);
+  return true;
+}
+
+std::vector<uuid> query_scheduler::remove(expression const& expr) {
+  std::vector<uuid> orphans;
+  auto q = queries_.find(expr);
+  if (q == queries_.end())
+    return orphans;
+  for (auto r = running_.begin(); r != running_.end(); )
+    if (r->second.erase(expr) > 0 && r->second.empty())
+      r = running_.erase(r);
+    else
+      ++r;
+  auto& ring = rings_[q->second.prio];
+  ring.erase(std::find(ring.begin(), ring.end(), expr));
+  auto pending = std::move(q->second.pending);
+  queries_.erase(q);
+  for (auto& part : pending) {
+    auto waits = [&](auto& x) {
+      auto& other = x.second.pending;
+      return std::find(other.begin(), other.end(), part) != other.end();
+    };
+    if (std::none_of(queries_.begin(), queries_.end(), waits))
+      orphans.push_back(part);
+  }
+  return orphans;
+}
+
+bool query_scheduler::busy(uuid const& part) const {
+  return running_.count(part) > 0;
+}
+
+size_t query_scheduler::pending() const {
+  size_t n = 0;
+  for (auto& q : queries_)
+    n += q.second.pending.size();
+  return n;
+}
+
+size_t query_scheduler::pending(expression const& expr) const {
+  auto q = queries_.find(expr);
+  return q == queries_.end() ? 0 : q->second.pending.size();
+}
+
+size_t query_scheduler::pending(priority p) const {
+  size_t n = 0;
+  for (auto& q : queries_)
+    if (q.second.prio == p)
+      n += q.second.pending.size();
+  return n;
+}
+
+size_t query_scheduler::inflight(expression const& expr) const {
+  auto q = queries_.find(expr);
+  return q == queries_.end() ? 0 : q->second.inflight;
+}
+
+size_t query_scheduler::queries() const {
+  return queries_.size();
+}
+
+size_t query_scheduler::max_inflight() const {
+  return max_inflight_;
+}
+
+void query_scheduler::erase_if_idle(
+  std::map<expression, query_state>::iterator q) {
+  if (!q->second.pending.empty() || q->second.inflight > 0)
+    return;
+  auto& ring = rings_[q->second.prio];
+  ring.erase(std::find(ring.begin(), ring.end(), q->first));
+  queries_.erase(q);
+}
+
+} // namespace detail
+} // namespace vast
@@ -0,0 +1,139 @@
+#ifndef VAST_DETAIL_QUERY_SCHEDULER_H
+#define VAST_DETAIL_QUERY_SCHEDULER_H
+
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/expression.h"
+#include "vast/optional.h"
+#include "vast/uuid.h"
+#include "vast/util/flat_set.h"
+
+namespace vast {
+namespace detail {
+
+/// Decides in which order the INDEX loads partitions for historical queries.
+///
+/// Each query belongs to a priority class. The scheduler always serves the
+/// highest class with pending work first. Within a class, it hands out
+/// partitions round-robin across queries so that a large scan cannot starve
+/// smaller ones. Moreover, a single query never has more than a fixed number
+/// of partitions in flight. When the scheduler selects a partition, all other
+/// queries waiting on the same partition piggyback on the load.
+class query_scheduler {
+public:
+  /// The scheduling class of a query.
+  enum priority : int {
+    low = 0,  ///< Batch queries, e.g., large exports.
+    high = 1  ///< Interactive queries.
+  };
+
+  /// A partition selected for loading, plus all queries to evaluate on it.
+  using selection = std::pair<uuid, std::vector<expression>>;
+
+  /// Constructs a scheduler.
+  /// @param max_inflight The maximum number of partitions that a single query
+  ///                     may have in flight at the same time.
+  /// @pre `max_inflight > 0`
+  query_scheduler(size_t max_inflight = 5);
+
+  /// Registers a query. If the query exists already, the scheduler keeps the
+  /// higher of the two priorities.
+  /// @param expr The query expression.
+  /// @param p The priority of *expr*.
+  void add(expression const& expr, priority p);
+
+  /// Enqueues a partition which must be loaded before evaluating a query.
+  /// @param expr The query to enqueue *part* for.
+  /// @param part The partition to load.
+  /// @pre *expr* has been registered via ::add.
+  void enqueue(expression const& expr, uuid const& part);
+
+  /// Records that a query runs on an already loaded partition.
+  /// @param expr The query evaluating on *part*.
+  /// @param part The partition in memory.
+  /// @pre *expr* has been registered via ::add.
+  void dispatch(expression const& expr, uuid const& part);
+
+  /// Selects the next partition to load.
+  /// @param admit A predicate deciding whether the caller can load a given
+  ///              partition right now. If it rejects the partition which is
+  ///              due next, the scheduler selects nothing and leaves its state
+  ///              untouched, so that large partitions cannot starve.
+  /// @returns The next partition to load along with all queries waiting for
+  ///          it, or nothing if no query can make progress.
+  optional<selection>
+  next(std::function<bool(uuid const&)> const& admit = {});
+
+  /// Retrieves the partitions which are likely to be selected after the
+  /// currently running ones, without modifying the schedule.
+  /// @param n The maximum number of partitions to return.
+  /// @returns Up to *n* distinct enqueued partitions in scheduling order.
+  std::vector<uuid> peek(size_t n) const;
+
+  /// Records that a query has finished on a partition.
+  /// @param expr The query.
+  /// @param part The partition which *expr* completed.
+  /// @returns `true` iff *part* has no more queries running on it.
+  bool complete(expression const& expr, uuid const& part);
+
+  /// Removes all state of a query, including its enqueued partitions.
+  /// @param expr The query to remove.
+  /// @returns The enqueued partitions of *expr* that no other query waits for.
+  std::vector<uuid> remove(expression const& expr);
+
+  /// Checks whether any query currently runs on a partition.
+  /// @param part The partition to check.
+  /// @returns `true` iff at least one query runs on *part*.
+  bool busy(uuid const& part) const;
+
+  /// Retrieves the total queue depth.
+  /// @returns The number of enqueued (query, partition) pairs.
+  size_t pending() const;
+
+  /// Retrieves the queue depth of a single query.
+  /// @param expr The query.
+  /// @returns The number of partitions enqueued for *expr*.
+  size_t pending(expression const& expr) const;
+
+  /// Retrieves the queue depth of a priority class.
+  /// @param p The priority class.
+  /// @returns The number of (query, partition) pairs enqueued with *p*.
+  size_t pending(priority p) const;
+
+  /// Retrieves the number of partitions a query has in flight.
+  /// @param expr The query.
+  /// @returns The number of partitions *expr* runs on.
+  size_t inflight(expression const& expr) const;
+
+  /// Retrieves the number of registered queries.
+  size_t queries() const;
+
+  /// Retrieves the maximum number of partitions per query in flight.
+  size_t max_inflight() const;
+
+private:
+  struct query_state {
+    priority prio = high;
+    std::deque<uuid> pending;
+    size_t inflight = 0;
+  };
+
+  static constexpr size_t num_priorities = 2;
+
+  void erase_if_idle(std::map<expression, query_state>::iterator q);
+
+  size_t max_inflight_;
+  std::map<expression, query_state> queries_;
+  std::list<expression> rings_[num_priorities];
+  std::unordered_map<uuid, util::flat_set<expression>> running_;
+};
+
+} // namespace detail
+} // namespace vast
+
+#endif
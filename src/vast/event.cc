@@ -38,4 +38,8 @@ time::point event::timestamp() const {
   return timestamp_;
 }
 
+size_t footprint(event const& e) {
+  return sizeof(event) - sizeof(data) + footprint(e.data());
+}
+
 } // namespace vast
@@ -63,6 +63,11 @@ private:
   time::point timestamp_;
 };
 
+/// Estimates the memory an event occupies.
+/// @param e The event to inspect.
+/// @returns The estimated number of bytes *e* occupies in memory.
+size_t footprint(event const& e);
+
 } // namespace vast
 
 #endif
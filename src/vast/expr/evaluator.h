@@ -1,6 +1,9 @@
 #ifndef VAST_EXPR_EVALUATOR_H
 #define VAST_EXPR_EVALUATOR_H
 
+#include <algorithm>
+#include <vector>
+
 #include "vast/expression.h"
 
 namespace vast {
@@ -48,14 +51,39 @@ struct bitstream_evaluator {
   }
 
   Bitstream operator()(conjunction const& con) const {
-    auto hits = visit(*this, con[0]);
-    if (hits.empty() || hits.all_zeros())
-      return {};
-    for (size_t i = 1; i < con.size(); ++i) {
-      hits &= visit(*this, con[i]);
-      if (hits.empty() || hits.all_zeros()) // short-circuit
+    // Predicate hits are readily available, so we intersect them first, in
+    // ascending order of their cardinality. This shrinks the result as early
+    // as possible. The remaining operands follow in their given order.
+    std::vector<std::pair<size_t, Bitstream const*>> preds;
+    std::vector<expression const*> rest;
+    for (auto& op : con)
+      if (auto p = get<predicate>(op)) {
+        auto bs = static_cast<Derived const*>(this)->lookup(*p);
+        if (!bs || bs->empty() || bs->all_zeros()) // short-circuit
+          return {};
+        preds.emplace_back(bs->count(), bs);
+      } else {
+        rest.push_back(&op);
+      }
+    std::sort(preds.begin(), preds.end(), [](auto& x, auto& y) {
+      return x.first < y.first;
+    });
+    Bitstream hits;
+    auto first = true;
+    auto intersect = [&](Bitstream const& bs) {
+      if (first)
+        hits = bs;
+      else
+        hits &= bs;
+      first = false;
+      return !(hits.empty() || hits.all_zeros());
+    };
+    for (auto& p : preds)
+      if (!intersect(*p.second))
+        return {};
+    for (auto op : rest)
+      if (!intersect(visit(*this, *op)))
         return {};
-    }
     return hits;
   }
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "vast/expr/normalize.h"
 
 #include "vast/expression.h"
@@ -113,12 +115,199 @@ expression denegator::operator()(predicate const& p) const {
   return predicate{p.lhs, negate_ ? negate(p.op) : p.op, p.rhs};
 }
 
+namespace {
+
+bool is_lower_bound(relational_operator op) {
+  return op == greater || op == greater_equal;
+}
+
+bool is_upper_bound(relational_operator op) {
+  return op == less || op == less_equal;
+}
+
+// Only totally ordered data qualifies for collapsing ranges.
+bool is_ordered(data const& d) {
+  return is<integer>(d) || is<count>(d) || is<real>(d) || is<time::point>(d)
+         || is<time::duration>(d);
+}
+
+// Checks whether bound *x* restricts more than bound *y*, given that both
+// apply to the same extractor and go in the same direction.
+bool tighter(predicate const& x, predicate const& y) {
+  auto& a = *get<data>(x.rhs);
+  auto& b = *get<data>(y.rhs);
+  if (a == b)
+    return x.op == greater || x.op == less;
+  return is_lower_bound(x.op) ? b < a : a < b;
+}
+
+template <typename Connective>
+void deduplicate(Connective& xs, expression x) {
+  if (std::find(xs.begin(), xs.end(), x) == xs.end())
+    xs.push_back(std::move(x));
+}
+
+} // namespace <anonymous>
+
+expression collapser::operator()(none) const {
+  return nil;
+}
+
+expression collapser::operator()(conjunction const& c) const {
+  conjunction copy;
+  for (auto& op : c) {
+    auto x = visit(*this, op);
+    auto p = get<predicate>(x);
+    auto d = p ? get<data>(p->rhs) : nullptr;
+    if (!d || !is_ordered(*d)
+        || !(is_lower_bound(p->op) || is_upper_bound(p->op))) {
+      deduplicate(copy, std::move(x));
+      continue;
+    }
+    // Look for an existing bound in the same direction on the same extractor.
+    auto same_bound = [&](expression const& y) {
+      auto q = get<predicate>(y);
+      if (!q || !(q->lhs == p->lhs)
+          || !(is_lower_bound(q->op) || is_upper_bound(q->op))
+          || is_lower_bound(q->op) != is_lower_bound(p->op))
+        return false;
+      auto e = get<data>(q->rhs);
+      return e && which(*e) == which(*d);
+    };
+    auto i = std::find_if(copy.begin(), copy.end(), same_bound);
+    if (i == copy.end())
+      copy.push_back(std::move(x));
+    else if (tighter(*p, *get<predicate>(*i)))
+      *i = std::move(x);
+  }
+  return copy.size() == 1 ? copy[0] : copy;
+}
+
+expression collapser::operator()(disjunction const& d) const {
+  disjunction copy;
+  for (auto& op : d)
+    deduplicate(copy, visit(*this, op));
+  return copy.size() == 1 ? copy[0] : copy;
+}
+
+expression collapser::operator()(negation const& n) const {
+  return {negation{visit(*this, n.expression())}};
+}
+
+expression collapser::operator()(predicate const& p) const {
+  return {p};
+}
+
+namespace {
+
+template <typename Connective>
+Connective sort_by_cost(Connective const& xs, sorter const& s) {
+  std::vector<std::pair<size_t, expression>> ops;
+  for (auto& op : xs) {
+    auto x = visit(s, op);
+    auto c = cost(x);
+    ops.emplace_back(c, std::move(x));
+  }
+  std::stable_sort(ops.begin(), ops.end(), [](auto& x, auto& y) {
+    return x.first < y.first;
+  });
+  Connective result;
+  for (auto& op : ops)
+    result.push_back(std::move(op.second));
+  return result;
+}
+
+struct cost_estimator {
+  size_t operator()(none) const {
+    return 0;
+  }
+
+  size_t operator()(conjunction const& c) const {
+    size_t result = 0;
+    for (auto& op : c)
+      result += visit(*this, op);
+    return result;
+  }
+
+  size_t operator()(disjunction const& d) const {
+    size_t result = 0;
+    for (auto& op : d)
+      result += visit(*this, op);
+    return result;
+  }
+
+  size_t operator()(negation const& n) const {
+    return visit(*this, n.expression());
+  }
+
+  size_t operator()(predicate const& p) const {
+    size_t op_cost = 0;
+    switch (p.op) {
+      case equal:
+      case not_equal:
+        op_cost = 1;
+        break;
+      case less:
+      case less_equal:
+      case greater:
+      case greater_equal:
+        op_cost = 2;
+        break;
+      case in:
+      case not_in:
+      case ni:
+      case not_ni:
+        op_cost = 4;
+        break;
+      case match:
+      case not_match:
+        op_cost = 8;
+        break;
+    }
+    // Meta data lookups hit a single, small index per event type. Type
+    // extractors may hit many indexes per event type.
+    if (is<event_extractor>(p.lhs) || is<time_extractor>(p.lhs))
+      return op_cost;
+    if (is<type_extractor>(p.lhs))
+      return op_cost * 4;
+    return op_cost * 2;
+  }
+};
+
+} // namespace <anonymous>
+
+expression sorter::operator()(none) const {
+  return nil;
+}
+
+expression sorter::operator()(conjunction const& c) const {
+  return sort_by_cost(c, *this);
+}
+
+expression sorter::operator()(disjunction const& d) const {
+  return sort_by_cost(d, *this);
+}
+
+expression sorter::operator()(negation const& n) const {
+  return {negation{visit(*this, n.expression())}};
+}
+
+expression sorter::operator()(predicate const& p) const {
+  return {p};
+}
+
+size_t cost(expression const& expr) {
+  return visit(cost_estimator{}, expr);
+}
+
 expression normalize(expression const& expr) {
   expression r;
   r = visit(hoister{}, expr);
   r = visit(aligner{}, r);
   r = visit(denegator{}, r);
   r = visit(hoister{}, r);
+  r = visit(collapser{}, r);
+  r = visit(sorter{}, r);
   return r;
 }
 
@@ -1,6 +1,8 @@
 #ifndef VAST_EXPR_NORMALIZE_H
 #define VAST_EXPR_NORMALIZE_H
 
+#include <cstddef>
+
 #include "vast/none.h"
 
 namespace vast {
@@ -45,10 +47,42 @@ struct denegator {
   bool negate_ = false;
 };
 
+/// Removes duplicate operands from conjunctions and disjunctions, and
+/// collapses multiple range bounds on the same extractor within a
+/// conjunction into the tightest one, e.g., `x > 5 && x > 7 && x < 10`
+/// becomes `x > 7 && x < 10`.
+/// @pre Extractors are on the LHS of predicates.
+struct collapser {
+  expression operator()(none) const;
+  expression operator()(conjunction const& c) const;
+  expression operator()(disjunction const& d) const;
+  expression operator()(negation const& n) const;
+  expression operator()(predicate const& p) const;
+};
+
+/// Orders the operands of conjunctions and disjunctions by ascending
+/// estimated evaluation cost. Operands with equal cost retain their order.
+struct sorter {
+  expression operator()(none) const;
+  expression operator()(conjunction const& c) const;
+  expression operator()(disjunction const& d) const;
+  expression operator()(negation const& n) const;
+  expression operator()(predicate const& p) const;
+};
+
+/// Estimates the cost of evaluating an expression against the index. Meta
+/// data lookups are cheapest, followed by equality and range lookups,
+/// containment tests, and pattern matches.
+/// @param expr The expression to estimate.
+/// @returns A unitless cost of *expr*.
+size_t cost(expression const& expr);
+
 /// Normalizes an expression such that:
 ///   1. Single-element conjunctions/disjunctions don't exist.
 ///   2. Extractors end up always on the LHS of a predicate.
 ///   3. Negations are pushed down to the predicate level.
+///   4. Duplicate operands and redundant range bounds don't exist.
+///   5. Cheap operands come before expensive ones.
 expression normalize(expression const& expr);
 
 } // namespace expr
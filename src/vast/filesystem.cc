@@ -454,6 +454,45 @@ void traverse(path const& p, std::function<bool(path const&)> f) {
 #endif // VAST_POSIX
 }
 
+uint64_t disk_usage(path const& p) {
+#ifdef VAST_POSIX
+  struct stat st;
+  if (::lstat(p.str().data(), &st) != 0)
+    return 0;
+  if (S_ISREG(st.st_mode))
+    return st.st_size;
+  uint64_t result = 0;
+  if (S_ISDIR(st.st_mode))
+    traverse(p, [&](path const& inner) {
+      result += disk_usage(inner);
+      return true;
+    });
+  return result;
+#else
+  return 0;
+#endif // VAST_POSIX
+}
+
+void prefetch(path const& p) {
+  auto t = p.kind();
+  if (t == path::type::directory) {
+    traverse(p, [](path const& inner) {
+      prefetch(inner);
+      return true;
+    });
+    return;
+  }
+  if (t != path::type::regular_file)
+    return;
+#if defined(VAST_POSIX) && defined(POSIX_FADV_WILLNEED)
+  auto fd = ::open(p.str().data(), O_RDONLY);
+  if (fd < 0)
+    return;
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  ::close(fd);
+#endif
+}
+
 // Loads file contents into a string.
 trial<std::string> load_contents(path const& p) {
   std::string contents;
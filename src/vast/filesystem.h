@@ -7,6 +7,7 @@
 #  include <dirent.h>
 #endif
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -302,6 +303,18 @@ trial<void> mkdir(path const& p);
 ///          iterating.
 void traverse(path const& p, std::function<bool(path const&)> f);
 
+/// Computes the number of bytes a path occupies on the filesystem.
+/// @param p The path to a file or directory.
+/// @returns The size of *p* if it is a file, or the accumulated size of all
+///          files below *p* if it is a directory.
+uint64_t disk_usage(path const& p);
+
+/// Advises the operating system that a path will be read soon, such that it
+/// can fetch its contents into the page cache asynchronously.
+/// @param p The path to a file or directory. For directories, applies to all
+///          files below *p*.
+void prefetch(path const& p);
+
 // Loads file contents into a string.
 // @param p The path of the file to load.
 // @returns The contents of the file *p*.
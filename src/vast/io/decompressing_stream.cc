@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "vast/config.h"
+#include "vast/error.h"
+#include "vast/io/decompressing_stream.h"
+#include "vast/util/assert.h"
+
+#ifdef VAST_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef VAST_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace vast {
+namespace io {
+
+/// Decodes a compressed input stream block by block.
+class decompressing_input_stream::decoder {
+public:
+  virtual ~decoder() = default;
+
+  /// Decodes the next block of data.
+  /// @param source The compressed input.
+  /// @param out The buffer to decode into.
+  /// @param size The size of *out*.
+  /// @returns The number of bytes written into *out*, which is less than
+  ///          *size* only at the end of the input or after a failure.
+  virtual size_t decode(input_stream& source, uint8_t* out, size_t size) = 0;
+
+  /// Retrieves the reason why decoding stopped prematurely.
+  /// @returns A description of the failure, or an empty string if the
+  ///          decoder has not failed.
+  std::string const& failure() const {
+    return failure_;
+  }
+
+protected:
+  std::string failure_;
+};
+
+namespace {
+
+#ifdef VAST_HAVE_ZLIB
+class gzip_decoder : public decompressing_input_stream::decoder {
+public:
+  gzip_decoder() {
+    std::memset(&stream_, 0, sizeof(stream_));
+    // Adding 16 to the window bits accepts only the gzip format.
+    if (inflateInit2(&stream_, 15 + 16) != Z_OK)
+      failure_ = "failed to initialize gzip decoder";
+  }
+
+  ~gzip_decoder() {
+    inflateEnd(&stream_);
+  }
+
+  size_t decode(input_stream& source, uint8_t* out, size_t size) override {
+    stream_.next_out = out;
+    stream_.avail_out = static_cast<uInt>(size);
+    while (stream_.avail_out > 0 && failure_.empty()) {
+      if (stream_.avail_in == 0) {
+        void const* data;
+        size_t n;
+        if (!source.next(&data, &n)) {
+          if (in_member_)
+            failure_ = "truncated gzip input";
+          break;
+        }
+        auto max = size_t{std::numeric_limits<uInt>::max()};
+        if (n > max) {
+          source.rewind(n - max);
+          n = max;
+        }
+        stream_.next_in =
+          const_cast<Bytef*>(reinterpret_cast<Bytef const*>(data));
+        stream_.avail_in = static_cast<uInt>(n);
+      }
+      in_member_ = true;
+      auto r = inflate(&stream_, Z_NO_FLUSH);
+      if (r == Z_STREAM_END) {
+        // Log rotation often appends gzip members to an existing file, which
+        // we treat as one contiguous stream.
+        in_member_ = false;
+        if (inflateReset(&stream_) != Z_OK)
+          failure_ = "failed to reset gzip decoder";
+      } else if (r != Z_OK && r != Z_BUF_ERROR) {
+        failure_ = "corrupt gzip input";
+        if (stream_.msg)
+          failure_ += std::string{": "} + stream_.msg;
+      }
+    }
+    return size - stream_.avail_out;
+  }
+
+private:
+  z_stream stream_;
+  bool in_member_ = false;
+};
+#endif
+
+#ifdef VAST_HAVE_ZSTD
+class zstd_decoder : public decompressing_input_stream::decoder {
+public:
+  zstd_decoder() : stream_{ZSTD_createDStream()} {
+    if (stream_ == nullptr || ZSTD_isError(ZSTD_initDStream(stream_)))
+      failure_ = "failed to initialize zstd decoder";
+  }
+
+  ~zstd_decoder() {
+    ZSTD_freeDStream(stream_);
+  }
+
+  size_t decode(input_stream& source, uint8_t* out, size_t size) override {
+    ZSTD_outBuffer output = {out, size, 0};
+    while (output.pos < output.size && failure_.empty()) {
+      if (input_.pos == input_.size) {
+        void const* data;
+        size_t n;
+        if (source.next(&data, &n)) {
+          input_ = {data, n, 0};
+        } else if (hint_ == 0) {
+          break; // All frames are complete.
+        } else {
+          // The decoder may still hold output of the last frame. If it cannot
+          // make progress without more input, the frame is incomplete.
+          input_ = {nullptr, 0, 0};
+          auto pos = output.pos;
+          hint_ = ZSTD_decompressStream(stream_, &output, &input_);
+          if (ZSTD_isError(hint_))
+            failure_ = ZSTD_getErrorName(hint_);
+          else if (hint_ != 0 && output.pos == pos)
+            failure_ = "truncated zstd input";
+          continue;
+        }
+      }
+      // Consecutive frames decode as one contiguous stream.
+      hint_ = ZSTD_decompressStream(stream_, &output, &input_);
+      if (ZSTD_isError(hint_))
+        failure_ = std::string{"corrupt zstd input: "}
+                   + ZSTD_getErrorName(hint_);
+    }
+    return output.pos;
+  }
+
+private:
+  ZSTD_DStream* stream_;
+  ZSTD_inBuffer input_ = {nullptr, 0, 0};
+  // The return value of the last decompression call, which is 0 iff a frame
+  // ended and the decoder has flushed all its output.
+  size_t hint_ = 0;
+};
+#endif
+
+} // namespace <anonymous>
+
+file_compression detect_compression(void const* data, size_t size) {
+  static uint8_t const gzip_magic[] = {0x1f, 0x8b};
+  static uint8_t const zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+  auto has_prefix = [&](auto& magic) {
+    return size >= sizeof(magic) && std::memcmp(data, magic, sizeof(magic)) == 0;
+  };
+  if (has_prefix(gzip_magic))
+    return file_compression::gzip;
+  if (has_prefix(zstd_magic))
+    return file_compression::zstd;
+  return file_compression::none;
+}
+
+decompressing_input_stream::decompressing_input_stream(
+  std::unique_ptr<input_stream> source, file_compression method,
+  size_t block_size)
+  : source_{std::move(source)},
+    block_size_{block_size > 0 ? block_size : default_block_size} {
+  VAST_ASSERT(source_);
+  switch (method) {
+    default:
+      break;
+#ifdef VAST_HAVE_ZLIB
+    case file_compression::gzip:
+      decoder_ = std::make_unique<gzip_decoder>();
+      break;
+#endif
+#ifdef VAST_HAVE_ZSTD
+    case file_compression::zstd:
+      decoder_ = std::make_unique<zstd_decoder>();
+      break;
+#endif
+  }
+  if (decoder_)
+    thread_ = std::thread{[=] { run(); }};
+  else
+    done_ = true;
+}
+
+decompressing_input_stream::~decompressing_input_stream() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool decompressing_input_stream::next(void const** data, size_t* size) {
+  if (rewind_bytes_ > 0) {
+    *data = current_.data() + current_.size() - rewind_bytes_;
+    *size = rewind_bytes_;
+    rewind_bytes_ = 0;
+    return true;
+  }
+  std::unique_lock<std::mutex> lock{mutex_};
+  cv_.wait(lock, [&] { return !full_.empty() || done_; });
+  if (full_.empty())
+    return false;
+  // Hand the previous block back to the decoder thread for reuse.
+  if (current_.capacity() > 0)
+    empty_.push_back(std::move(current_));
+  current_ = std::move(full_.front());
+  full_.pop_front();
+  lock.unlock();
+  cv_.notify_all();
+  total_bytes_ += current_.size();
+  *data = current_.data();
+  *size = current_.size();
+  return true;
+}
+
+void decompressing_input_stream::rewind(size_t bytes) {
+  rewind_bytes_ = std::min(rewind_bytes_ + bytes, current_.size());
+}
+
+bool decompressing_input_stream::skip(size_t bytes) {
+  void const* data;
+  size_t size = 0;
+  while (bytes > 0) {
+    if (!next(&data, &size))
+      return false;
+    if (size > bytes) {
+      rewind(size - bytes);
+      return true;
+    }
+    bytes -= size;
+  }
+  return true;
+}
+
+uint64_t decompressing_input_stream::bytes() const {
+  return total_bytes_ - rewind_bytes_;
+}
+
+trial<void> decompressing_input_stream::status() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!failure_.empty())
+    return error{failure_};
+  return nothing;
+}
+
+void decompressing_input_stream::run() {
+  for (;;) {
+    std::vector<uint8_t> block;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [&] { return stop_ || full_.size() < max_blocks_ahead; });
+      if (stop_)
+        return;
+      if (!empty_.empty()) {
+        block = std::move(empty_.back());
+        empty_.pop_back();
+      }
+    }
+    block.resize(block_size_);
+    auto n = decoder_->decode(*source_, block.data(), block.size());
+    block.resize(n);
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (n > 0) {
+        full_.push_back(std::move(block));
+      } else {
+        done_ = true;
+        failure_ = decoder_->failure();
+      }
+    }
+    cv_.notify_all();
+    if (n == 0)
+      return;
+  }
+}
+
+trial<std::unique_ptr<input_stream>>
+make_decompressing_input_stream(std::unique_ptr<input_stream> source,
+                                size_t block_size) {
+  void const* data;
+  size_t size;
+  if (!source->next(&data, &size))
+    return std::move(source);
+  auto method = detect_compression(data, size);
+  source->rewind(size);
+  switch (method) {
+    case file_compression::none:
+      return std::move(source);
+    case file_compression::gzip:
+#ifndef VAST_HAVE_ZLIB
+      return error{"not compiled with gzip support"};
+#else
+      break;
+#endif
+    case file_compression::zstd:
+#ifndef VAST_HAVE_ZSTD
+      return error{"not compiled with zstd support"};
+#else
+      break;
+#endif
+  }
+  return std::unique_ptr<input_stream>{
+    std::make_unique<decompressing_input_stream>(std::move(source), method,
+                                                 block_size)};
+}
+
+} // namespace io
+} // namespace vast
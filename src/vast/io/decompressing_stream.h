@@ -0,0 +1,91 @@
+#ifndef VAST_IO_DECOMPRESSING_STREAM_H
+#define VAST_IO_DECOMPRESSING_STREAM_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vast/trial.h"
+#include "vast/io/stream.h"
+
+namespace vast {
+namespace io {
+
+/// The compression formats of files which input streams can decode.
+enum class file_compression {
+  none,
+  gzip,
+  zstd
+};
+
+/// Determines the compression format of a file from its leading bytes.
+/// @param data The beginning of the file.
+/// @param size The number of bytes in *data*.
+/// @returns The compression format of the file.
+file_compression detect_compression(void const* data, size_t size);
+
+/// An input stream which decompresses a gzip or zstd file. A background
+/// thread decodes the next blocks while the consumer processes the current
+/// one, so that decompression overlaps with parsing.
+class decompressing_input_stream : public input_stream {
+public:
+  class decoder;
+
+  /// Constructs a decompressing input stream.
+  /// @param source The compressed input.
+  /// @param method The compression format of *source*.
+  /// @param block_size The number of uncompressed bytes per block.
+  /// @pre `method != file_compression::none`
+  decompressing_input_stream(std::unique_ptr<input_stream> source,
+                             file_compression method, size_t block_size = 0);
+
+  ~decompressing_input_stream();
+
+  bool next(void const** data, size_t* size) override;
+  void rewind(size_t bytes) override;
+  bool skip(size_t bytes) override;
+  uint64_t bytes() const override;
+  trial<void> status() const override;
+
+private:
+  // The number of decoded blocks the background thread may run ahead.
+  static constexpr size_t max_blocks_ahead = 2;
+
+  void run();
+
+  std::unique_ptr<input_stream> source_;
+  std::unique_ptr<decoder> decoder_;
+  size_t block_size_;
+  std::vector<uint8_t> current_;
+  size_t rewind_bytes_ = 0;
+  uint64_t total_bytes_ = 0;
+  // Shared with the background thread.
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::vector<uint8_t>> full_;
+  std::vector<std::vector<uint8_t>> empty_;
+  bool done_ = false;
+  bool stop_ = false;
+  std::string failure_;
+  std::thread thread_;
+};
+
+/// Wraps an input stream into a ::decompressing_input_stream if its content
+/// is compressed.
+/// @param source The input stream to inspect.
+/// @param block_size The number of uncompressed bytes per block.
+/// @returns *source* if its content is not compressed, a decompressing
+///          stream reading from *source* if VAST supports its compression
+///          format, and an error otherwise.
+trial<std::unique_ptr<input_stream>>
+make_decompressing_input_stream(std::unique_ptr<input_stream> source,
+                                size_t block_size = 0);
+
+} // namespace io
+} // namespace vast
+
+#endif
@@ -0,0 +1,74 @@
+#include <cstring>
+
+#include "vast/io/line_reader.h"
+#include "vast/io/stream.h"
+
+namespace vast {
+namespace io {
+
+line_reader::line_reader(input_stream& in) : in_{in} {
+}
+
+bool line_reader::next() {
+  auto spanning = false;
+  partial_.clear();
+  while (true) {
+    if (pos_ == size_) {
+      void const* data;
+      if (!in_.next(&data, &size_)) {
+        size_ = pos_ = 0;
+        if (!spanning)
+          return false;
+        line_ = partial_;
+        return true;
+      }
+      buf_ = reinterpret_cast<char const*>(data);
+      pos_ = 0;
+      // A \r at the end of the previous block may continue as \r\n.
+      if (swallow_newline_) {
+        swallow_newline_ = false;
+        if (size_ > 0 && buf_[0] == '\n')
+          ++pos_;
+        continue;
+      }
+    }
+    auto first = buf_ + pos_;
+    auto remaining = size_ - pos_;
+    // Find the next separator with memchr, which C libraries implement with
+    // vectorized instructions. A \r can only terminate the line if it occurs
+    // before the next \n.
+    auto nl = static_cast<char const*>(std::memchr(first, '\n', remaining));
+    auto cr = static_cast<char const*>(
+      std::memchr(first, '\r', nl ? nl - first : remaining));
+    auto last = cr ? cr : nl;
+    if (!last) {
+      partial_.append(first, remaining);
+      spanning = true;
+      pos_ = size_;
+      continue;
+    }
+    pos_ = last - buf_ + 1;
+    if (cr) {
+      if (pos_ < size_) {
+        if (buf_[pos_] == '\n')
+          ++pos_;
+      } else {
+        swallow_newline_ = true;
+      }
+    }
+    if (spanning) {
+      partial_.append(first, last - first);
+      line_ = partial_;
+    } else {
+      line_ = {first, static_cast<size_t>(last - first)};
+    }
+    return true;
+  }
+}
+
+util::string_ref line_reader::line() const {
+  return line_;
+}
+
+} // namespace io
+} // namespace vast
@@ -0,0 +1,48 @@
+#ifndef VAST_IO_LINE_READER_H
+#define VAST_IO_LINE_READER_H
+
+#include <string>
+
+#include "vast/util/string_ref.h"
+
+namespace vast {
+namespace io {
+
+class input_stream;
+
+/// Splits an input stream into lines without copying them. Like
+/// ::getline, the reader treats `\r`, `\n`, and `\r\n` as line separator.
+/// Lines fully contained in a block of the underlying stream reference the
+/// block directly. Only lines spanning multiple blocks get assembled in an
+/// internal buffer. Therefore, input streams with large blocks minimize
+/// copying.
+class line_reader {
+public:
+  /// Constructs a line reader.
+  /// @param in The input stream to read from.
+  explicit line_reader(input_stream& in);
+
+  /// Advances to the next line.
+  /// @returns `true` *iff* extracting a line from the input succeeded. A
+  ///          final line without a separator counts as a line.
+  bool next();
+
+  /// Retrieves the current line.
+  /// @returns The current line, which remains valid until the next call to
+  ///          ::next.
+  util::string_ref line() const;
+
+private:
+  input_stream& in_;
+  char const* buf_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  bool swallow_newline_ = false;
+  std::string partial_;
+  util::string_ref line_;
+};
+
+} // namespace io
+} // namespace vast
+
+#endif
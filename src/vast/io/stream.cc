@@ -12,6 +12,10 @@ buffer<void const> input_stream::next_block() {
   return {};
 }
 
+trial<void> input_stream::status() const {
+  return nothing;
+}
+
 buffer<void> output_stream::next_block() {
   void* out;
   size_t size;
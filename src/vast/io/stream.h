@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <utility>
 #include "vast/config.h"
+#include "vast/trial.h"
 #include "vast/io/buffer.h"
 
 namespace vast {
@@ -45,6 +46,11 @@ public:
   /// @returns The number of bytes this input stream processed.
   virtual uint64_t bytes() const = 0;
 
+  /// Checks whether the stream ended because of an error. Streams which
+  /// cannot distinguish errors from the end of the input always succeed.
+  /// @returns An error if next() returned `false` because of a failure.
+  virtual trial<void> status() const;
+
 protected:
   input_stream() = default;
 };
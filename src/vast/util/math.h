@@ -24,6 +24,8 @@
 #define VAST_UTIL_MATH_H
 
 #include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace vast {
 namespace util {
@@ -93,6 +95,16 @@ constexpr int ilog(T x) {
   return x > 0 ? detail::ilog_helper<base>(x) : -1;
 }
 
+/// Updates an exponentially weighted moving average, which smoothes out
+/// bursts in a series of measurements. The first sample initializes the
+/// average.
+/// @param avg The average to update, or 0 if there is no sample yet.
+/// @param x The new sample.
+/// @param alpha The weight of *x*.
+inline void ewma(double& avg, double x, double alpha = 0.25) {
+  avg = avg == 0 ? x : avg + alpha * (x - avg);
+}
+
 } // namespace util
 } // namespace vast
 
@@ -1,5 +1,10 @@
+#include <cstring>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "vast/util/coding.h"
 #include "vast/util/string.h"
 
@@ -10,8 +15,85 @@ namespace {
 
 static constexpr char hex[] = "0123456789abcdef";
 
+// Finds the first occurrence of a character in a sequence, while remembering
+// the candidates of the last 16-byte block scanned. Since separators
+// typically occur every few bytes, subsequent lookups often need not touch
+// memory again.
+class char_finder {
+public:
+  char_finder(char const* end, char c) : end_{end}, c_{c} {
+#ifdef __SSE2__
+    needle_ = _mm_set1_epi8(c);
+#endif
+  }
+
+  char const* operator()(char const* from) {
+#ifdef __SSE2__
+    while (true) {
+      if (block_ != nullptr && from < block_ + 16) {
+        auto candidates = mask_ & (~0u << (from - block_));
+        if (candidates != 0)
+          return block_ + __builtin_ctz(candidates);
+        from = block_ + 16;
+      }
+      if (end_ - from < 16)
+        break;
+      block_ = from;
+      auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(from));
+      mask_ = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle_));
+    }
+#endif
+    auto i = std::memchr(from, c_, end_ - from);
+    return i ? static_cast<char const*>(i) : end_;
+  }
+
+private:
+  char const* end_;
+  char c_;
+#ifdef __SSE2__
+  __m128i needle_;
+  char const* block_ = nullptr;
+  unsigned mask_ = 0;
+#endif
+};
+
 } // namespace <anonymous>
 
+void split(char const* begin, char const* end, std::string const& sep,
+           std::vector<std::pair<char const*, char const*>>& pos,
+           std::string const& esc, size_t max_splits, bool include_sep) {
+  VAST_ASSERT(!sep.empty());
+  char_finder find{end, sep[0]};
+  size_t splits = 0;
+  auto i = begin;
+  auto prev = i;
+  while (i != end) {
+    i = find(i);
+    // A separator must fit in the remaining string.
+    if (i == end || i + sep.size() > end)
+      break;
+    if (std::memcmp(i + 1, sep.data() + 1, sep.size() - 1) != 0) {
+      ++i;
+      continue;
+    }
+    // Make sure it's not an escaped match.
+    if (!esc.empty() && esc.size() < static_cast<size_t>(i - begin)
+        && std::memcmp(i - esc.size(), esc.data(), esc.size()) == 0) {
+      ++i;
+      continue;
+    }
+    if (splits++ == max_splits)
+      break;
+    pos.emplace_back(prev, i);
+    if (include_sep)
+      pos.emplace_back(i, i + sep.size());
+    i += sep.size();
+    prev = i;
+  }
+  if (prev != end)
+    pos.emplace_back(prev, end);
+}
+
 std::string byte_escape(std::string const& str) {
   std::string esc;
   esc.reserve(str.size());
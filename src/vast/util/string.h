@@ -58,21 +58,20 @@ std::string json_unescape(std::string const& str);
 /// @param begin The beginning of the string to split.
 /// @param end The end of the string to split.
 /// @param sep The seperator where to split.
+/// @param pos The vector to append the iterator pairs to, which allows for
+///            reusing its memory across invocations.
 /// @param esc The escape string. If *esc* occurrs immediately in front of
 ///            *sep*, then *sep* will not count as a separator.
 /// @param max_splits The maximum number of splits to perform.
 /// @param include_sep If `true`, also include the separator after each
 ///                    match.
 /// @pre `! sep.empty()`
-/// @returns A vector of iterator pairs each of which delimit a single field
-///          with a range *[start, end)*.
 template <typename Iterator>
-std::vector<std::pair<Iterator, Iterator>>
-split(Iterator begin, Iterator end, std::string const& sep,
-      std::string const& esc = "", size_t max_splits = -1,
-      bool include_sep = false) {
+void split(Iterator begin, Iterator end, std::string const& sep,
+           std::vector<std::pair<Iterator, Iterator>>& pos,
+           std::string const& esc = "", size_t max_splits = -1,
+           bool include_sep = false) {
   VAST_ASSERT(!sep.empty());
-  std::vector<std::pair<Iterator, Iterator>> pos;
   size_t splits = 0;
   auto i = begin;
   auto prev = i;
@@ -119,6 +118,38 @@ split(Iterator begin, Iterator end, std::string const& sep,
   }
   if (prev != end)
     pos.emplace_back(prev, end);
+}
+
+/// Splits a contiguous character sequence. This overload locates separator
+/// candidates 16 bytes at a time with SIMD instructions, and only checks the
+/// remaining separator characters and escapes at candidate positions.
+/// @see split
+void split(char const* begin, char const* end, std::string const& sep,
+           std::vector<std::pair<char const*, char const*>>& pos,
+           std::string const& esc = "", size_t max_splits = -1,
+           bool include_sep = false);
+
+/// Splits a string into a vector of iterator pairs representing the
+/// *[start, end)* range of each element.
+/// @tparam Iterator A random-access iterator to a character sequence.
+/// @param begin The beginning of the string to split.
+/// @param end The end of the string to split.
+/// @param sep The seperator where to split.
+/// @param esc The escape string. If *esc* occurrs immediately in front of
+///            *sep*, then *sep* will not count as a separator.
+/// @param max_splits The maximum number of splits to perform.
+/// @param include_sep If `true`, also include the separator after each
+///                    match.
+/// @pre `! sep.empty()`
+/// @returns A vector of iterator pairs each of which delimit a single field
+///          with a range *[start, end)*.
+template <typename Iterator>
+std::vector<std::pair<Iterator, Iterator>>
+split(Iterator begin, Iterator end, std::string const& sep,
+      std::string const& esc = "", size_t max_splits = -1,
+      bool include_sep = false) {
+  std::vector<std::pair<Iterator, Iterator>> pos;
+  split(begin, end, sep, pos, esc, max_splits, include_sep);
   return pos;
 }
 
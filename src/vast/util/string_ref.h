@@ -0,0 +1,90 @@
+#ifndef VAST_UTIL_STRING_REF_H
+#define VAST_UTIL_STRING_REF_H
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "vast/util/assert.h"
+#include "vast/util/operators.h"
+
+namespace vast {
+namespace util {
+
+/// A non-owning reference to a contiguous sequence of characters. The
+/// referenced characters must outlive the reference.
+class string_ref : totally_ordered<string_ref> {
+public:
+  using value_type = char;
+  using size_type = size_t;
+  using const_iterator = char const*;
+  using iterator = const_iterator;
+
+  /// Constructs an empty reference.
+  string_ref() = default;
+
+  /// Constructs a reference from a pointer and a length.
+  /// @param data The beginning of the character sequence.
+  /// @param size The number of characters in the sequence.
+  string_ref(char const* data, size_t size) : data_{data}, size_{size} {
+  }
+
+  /// Constructs a reference from a NUL-terminated string.
+  /// @param str The string to refer to.
+  string_ref(char const* str) : data_{str}, size_{std::strlen(str)} {
+  }
+
+  /// Constructs a reference to the contents of a string.
+  /// @param str The string to refer to.
+  string_ref(std::string const& str) : data_{str.data()}, size_{str.size()} {
+  }
+
+  char operator[](size_t i) const {
+    VAST_ASSERT(i < size_);
+    return data_[i];
+  }
+
+  const_iterator begin() const {
+    return data_;
+  }
+
+  const_iterator end() const {
+    return data_ + size_;
+  }
+
+  char const* data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /// Copies the referenced characters into a string.
+  /// @returns A string with the contents of this reference.
+  std::string str() const {
+    return {data_, size_};
+  }
+
+  friend bool operator==(string_ref const& x, string_ref const& y) {
+    return x.size_ == y.size_ && std::memcmp(x.data_, y.data_, x.size_) == 0;
+  }
+
+  friend bool operator<(string_ref const& x, string_ref const& y) {
+    auto r = std::memcmp(x.data_, y.data_, std::min(x.size_, y.size_));
+    return r == 0 ? x.size_ < y.size_ : r < 0;
+  }
+
+private:
+  char const* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace util
+} // namespace vast
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FIXTURES_SOURCES_H
+#define FIXTURES_SOURCES_H
+
+#include <vector>
+
+#include <caf/all.hpp>
+
+#include "vast/event.h"
+#include "vast/filesystem.h"
+#include "vast/actor/source/bro.h"
+#include "vast/io/file_stream.h"
+
+using namespace caf;
+using namespace vast;
+
+namespace fixtures {
+
+struct sources {
+  ~sources() {
+    self->await_all_other_actors_done();
+  }
+
+  // Monitors a source and registers the test actor as its sink.
+  void connect(actor const& src) {
+    self->monitor(src);
+    anon_send(src, put_atom::value, sink_atom::value, self);
+    self->receive([&](upstream_atom, actor const& a) { CHECK(a == src); });
+  }
+
+  // Connects a source and runs it.
+  void start(actor const& src) {
+    connect(src);
+    anon_send(src, run_atom::value);
+  }
+
+  // Handles the batches of a started source until it terminates and returns
+  // its exit reason.
+  template <typename... Handlers>
+  uint32_t drain(Handlers... handlers) {
+    uint32_t reason = exit::error;
+    auto done = false;
+    self->do_receive(
+      handlers...,
+      [&](down_msg const& d) {
+        reason = d.reason;
+        done = true;
+      }
+    ).until([&] { return done; });
+    self->await_all_other_actors_done();
+    return reason;
+  }
+
+  // Runs a source and collects all its events.
+  std::vector<event> collect(actor const& src) {
+    start(src);
+    std::vector<event> result;
+    auto reason = drain([&](std::vector<event> const& events) {
+      result.insert(result.end(), events.begin(), events.end());
+    });
+    CHECK(reason == exit::done);
+    return result;
+  }
+
+  // Parses a Bro log.
+  std::vector<event> read_bro_log(path const& file) {
+    auto is = std::make_unique<io::file_input_stream>(file);
+    return collect(self->spawn<source::bro>(std::move(is)));
+  }
+
+  scoped_actor self;
+};
+
+} // namespace fixtures
+
+#endif
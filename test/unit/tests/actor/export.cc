@@ -121,19 +121,22 @@ TEST(export) {
   auto i = 0;
   done = false;
   self->do_receive(
-    [&](uuid const&, event const& e) {
-      ++i;
-      // Verify contents of a few random events.
-      if (e.id() == 3)
-        CHECK(get<record>(e)->at(1) == "KKSlmtmkkxf");
-      if (e.id() == 41)
-      {
-        CHECK(get<record>(e)->at(1) == "7e0gZmKgGS4");
-        CHECK(get<record>(e)->at(4) == "TLS_RSA_WITH_RC4_128_MD5");
+    [&](uuid const&, std::vector<event> const& v) {
+      REQUIRE(!v.empty());
+      for (auto& e : v) {
+        ++i;
+        // Verify contents of a few random events.
+        if (e.id() == 3)
+          CHECK(get<record>(e)->at(1) == "KKSlmtmkkxf");
+        if (e.id() == 41)
+        {
+          CHECK(get<record>(e)->at(1) == "7e0gZmKgGS4");
+          CHECK(get<record>(e)->at(4) == "TLS_RSA_WITH_RC4_128_MD5");
+        }
+        // The last event.
+        if (e.id() == 102)
+          CHECK(get<record>(e)->at(1) == "mXRBhfuUqag");
       }
-      // The last event.
-      if (e.id() == 102)
-        CHECK(get<record>(e)->at(1) == "mXRBhfuUqag");
     },
     [&](uuid const&, progress_atom, double, uint64_t) { /* nop */ },
     [&](uuid const&, done_atom, time::extent) {
@@ -182,8 +185,8 @@ TEST(export) {
   i = 0;
   done = false;
   self->do_receive(
-    [&](uuid const&, event const&) {
-      ++i;
+    [&](uuid const&, std::vector<event> const& v) {
+      i += v.size();
     },
     [&](uuid const&, progress_atom, double, uint64_t) { /* nop */ },
     [&](uuid const&, done_atom, time::extent) {
@@ -0,0 +1,57 @@
+#include <caf/all.hpp>
+
+#include "vast/filesystem.h"
+#include "vast/actor/identifier.h"
+#include "vast/actor/key_value_store.h"
+
+#define SUITE actors
+#include "test.h"
+
+using namespace caf;
+using namespace vast;
+
+TEST(identifier) {
+  path dir = "vast-test-identifier";
+  scoped_actor self;
+  self->on_sync_failure([&] {
+    FAIL("got unexpected message: " << to_string(self->current_message()));
+  });
+  auto store = self->spawn<key_value_store>();
+  self->send(store, leader_atom::value);
+  auto lease = [&](actor const& a, event_id n, event_id& last) {
+    self->sync_send(a, request_atom::value, n).await(
+      [&](id_atom, event_id from, event_id to) {
+        CHECK(from >= last);
+        CHECK(to > from);
+        CHECK(to - from <= n);
+        last = to;
+      }
+    );
+  };
+  MESSAGE("leasing IDs");
+  auto id = self->spawn<monitored>(identifier::actor, store, dir, event_id{100});
+  event_id last = 0;
+  for (auto i = 0; i < 10; ++i)
+    lease(id, 42, last);
+  MESSAGE("checking the little-endian lease record");
+  auto record = load_contents(dir / "lease");
+  REQUIRE(record);
+  REQUIRE(record->size() == 16);
+  event_id next = 0;
+  for (auto i = 0; i < 8; ++i)
+    next |= event_id{static_cast<uint8_t>((*record)[i])} << (8 * i);
+  // The identifier records the lease before handing out IDs.
+  CHECK(next == last);
+  MESSAGE("leasing IDs after restart");
+  self->send_exit(id, exit::done);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == id); });
+  id = self->spawn(identifier::actor, store, dir, event_id{100});
+  lease(id, 42, last);
+  MESSAGE("leasing more IDs than available");
+  lease(id, 1000000, last);
+  lease(id, 1000000, last);
+  self->send_exit(id, exit::done);
+  self->send_exit(store, exit::done);
+  self->await_all_other_actors_done();
+  rm(dir);
+}
@@ -0,0 +1,99 @@
+#include <caf/all.hpp>
+
+#include "vast/event.h"
+#include "vast/actor/importer.h"
+
+#define SUITE actors
+#include "test.h"
+
+using namespace caf;
+using namespace vast;
+
+TEST(importer) {
+  scoped_actor self;
+  auto imp = self->spawn<importer, priority_aware>(event_id{10});
+  MESSAGE("registering ourselves as identifier, archive, and index");
+  self->send(imp, put_atom::value, identifier_atom::value, self);
+  self->send(imp, put_atom::value, archive_atom::value, self);
+  self->send(imp, put_atom::value, index_atom::value, self);
+  auto expect_request = [&](event_id n) {
+    self->receive(
+      [&](request_atom, event_id x) { CHECK(x == n); },
+      [&](upstream_atom, actor const& a) { CHECK(a == imp); },
+      others >> [&] { FAIL("unexpected message"); }
+    );
+  };
+  expect_request(10);
+  MESSAGE("sending batches before granting a lease");
+  auto t = type::record{{"c", type::count{}}};
+  t.name("test");
+  for (auto i = 0u; i < 3; ++i) {
+    std::vector<event> events;
+    for (auto j = 0u; j < 4; ++j)
+      events.push_back(event::make(record{count{i * 4 + j}}, t));
+    self->send(imp, std::move(events));
+  }
+  // The second batch exceeds the requested IDs by more than half a lease.
+  self->receive(
+    [&](upstream_atom, actor const& a) { CHECK(a == imp); }
+  );
+  expect_request(10);
+  MESSAGE("granting leases out of contiguous order");
+  self->send(imp, id_atom::value, event_id{0}, event_id{10});
+  self->send(imp, id_atom::value, event_id{100}, event_id{110});
+  auto expected = std::vector<std::pair<event_id, size_t>>{
+    {0, 4}, {4, 4}, {8, 2}, {100, 2}};
+  auto c = count{0};
+  for (auto& x : expected) {
+    // Once for ARCHIVE, once for INDEX.
+    for (auto i = 0; i < 2; ++i)
+      self->receive([&](std::vector<event> const& events) {
+        REQUIRE(events.size() == x.second);
+        for (auto j = 0u; j < events.size(); ++j) {
+          CHECK(events[j].id() == x.first + j);
+          CHECK(get<record>(events[j])->at(0) == c + j);
+        }
+      });
+    c += x.second;
+  }
+  self->send_exit(imp, exit::done);
+  self->await_all_other_actors_done();
+}
+
+TEST(importer credit) {
+  scoped_actor self;
+  auto imp = self->spawn<importer, priority_aware>(event_id{1 << 20});
+  self->send(imp, put_atom::value, identifier_atom::value, self);
+  self->send(imp, put_atom::value, archive_atom::value, self);
+  self->send(imp, put_atom::value, index_atom::value, self);
+  self->receive([&](request_atom, event_id n) { CHECK(n == 1 << 20); });
+  self->receive([&](upstream_atom, actor const& a) { CHECK(a == imp); });
+  self->receive([&](upstream_atom, actor const& a) { CHECK(a == imp); });
+  self->send(imp, id_atom::value, event_id{0}, event_id{1 << 20});
+  MESSAGE("registering ourselves as source");
+  self->send(imp, upstream_atom::value, self);
+  self->receive([&](credit_atom, uint64_t events, uint64_t bytes) {
+    CHECK(events == 1 << 16);
+    CHECK(bytes == 64 << 20);
+  });
+  MESSAGE("consuming more than half of the credit while overloaded");
+  self->send(imp, overload_atom::value);
+  auto t = type::record{{"c", type::count{}}};
+  t.name("test");
+  std::vector<event> events;
+  for (auto i = 0u; i <= 1 << 15; ++i)
+    events.push_back(event::make(record{count{i}}, t));
+  auto n = events.size();
+  auto bytes = uint64_t{n * 8};
+  self->send(imp, std::move(events), bytes);
+  for (auto i = 0; i < 2; ++i)
+    self->receive([&](std::vector<event> const& xs) { CHECK(xs.size() == n); });
+  MESSAGE("getting credit back after underload");
+  self->send(imp, underload_atom::value);
+  self->receive([&](credit_atom, uint64_t events, uint64_t b) {
+    CHECK(events == n);
+    CHECK(b == bytes);
+  });
+  self->send_exit(imp, exit::done);
+  self->await_all_other_actors_done();
+}
@@ -82,6 +82,19 @@ TEST(index) {
   // Make sure that we didn't get any new hits.
   CHECK(self->mailbox().count() == 0);
 
+  MESSAGE("creating a streaming continuous query");
+  self->send(idx, *expr, continuous + streaming, self);
+  self->receive(
+    [&](actor const& t) {
+      REQUIRE(t != invalid_actor);
+      self->monitor(t);
+      task = t;
+    });
+  self->send(idx, events);
+  self->receive([&](bitstream_type const& bs) { CHECK(bs.count() == 95); });
+  self->send(idx, *expr, continuous_atom::value, disable_atom::value);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == task); });
+
   MESSAGE("cleaning up");
   self->send_exit(idx, exit::done);
   self->await_all_other_actors_done();
@@ -0,0 +1,185 @@
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+
+#include "vast/filesystem.h"
+#include "vast/actor/sink/arrow.h"
+#include "vast/actor/sink/ascii.h"
+#include "vast/actor/sink/bro.h"
+#include "vast/actor/sink/json.h"
+#include "vast/concept/convertible/vast/event.h"
+#include "vast/concept/convertible/to.h"
+#include "vast/concept/printable/vast/event.h"
+#include "vast/concept/printable/vast/json.h"
+#include "vast/concept/parseable/to.h"
+#include "vast/concept/parseable/vast/address.h"
+#include "vast/concept/parseable/vast/subnet.h"
+
+#define SUITE actors
+#include "test.h"
+#include "data.h"
+#include "fixtures/sources.h"
+
+using namespace caf;
+using namespace vast;
+
+namespace {
+
+// Sends events in two batches to a sink writing into a string buffer.
+template <typename Sink>
+std::string run_sink(std::vector<event> const& events) {
+  std::stringbuf buf;
+  scoped_actor self;
+  auto snk = self->spawn<Sink, monitored>(std::make_unique<std::ostream>(&buf));
+  auto half = events.begin() + events.size() / 2;
+  self->send(snk, uuid::random(), std::vector<event>(events.begin(), half));
+  self->send(snk, uuid::random(), std::vector<event>(half, events.end()));
+  self->send_exit(snk, exit::done);
+  self->receive([&](down_msg const& d) { CHECK(d.reason == exit::done); });
+  self->await_all_other_actors_done();
+  return buf.str();
+}
+
+template <typename T>
+T read(std::string const& buf, size_t pos) {
+  T x;
+  std::memcpy(&x, buf.data() + pos, sizeof(T));
+  return x;
+}
+
+// Locates a field of a FlatBuffers table, or returns 0 if absent.
+size_t field(std::string const& buf, size_t table, size_t id) {
+  auto vtable = table - read<int32_t>(buf, table);
+  if (4 + 2 * id >= read<uint16_t>(buf, vtable))
+    return 0;
+  auto offset = read<uint16_t>(buf, vtable + 4 + 2 * id);
+  return offset == 0 ? 0 : table + offset;
+}
+
+size_t follow(std::string const& buf, size_t pos) {
+  return pos + read<uint32_t>(buf, pos);
+}
+
+// Retrieves the number of rows of each record batch in an Arrow IPC stream.
+std::vector<int64_t> record_batch_lengths(std::string const& stream) {
+  std::vector<int64_t> result;
+  size_t pos = 0;
+  while (pos + 8 <= stream.size()) {
+    auto size = read<int32_t>(stream, pos + 4);
+    pos += 8;
+    if (size == 0)
+      break;
+    auto metadata = stream.substr(pos, size);
+    pos += size;
+    auto message = follow(metadata, 0);
+    auto header_type = field(metadata, message, 1);
+    if (header_type != 0 && read<uint8_t>(metadata, header_type) == 3) {
+      auto header = follow(metadata, field(metadata, message, 2));
+      result.push_back(read<int64_t>(metadata, field(metadata, header, 0)));
+    }
+    auto body = field(metadata, message, 3);
+    if (body != 0)
+      pos += read<int64_t>(metadata, body);
+  }
+  return result;
+}
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(sink_scope, fixtures::sources)
+
+TEST(arrow_sink) {
+  auto events = read_bro_log(m57_day11_18::ssl);
+  REQUIRE(events.size() == 113);
+  path dir = "vast-test-arrow-sink";
+  auto snk = self->spawn<sink::arrow, monitored>(dir, size_t{50});
+  MESSAGE("sending one event per message");
+  for (auto& e : events)
+    self->send(snk, uuid::random(), std::vector<event>{e});
+  self->send_exit(snk, exit::done);
+  self->receive([&](down_msg const& d) { CHECK(d.reason == exit::done); });
+  self->await_all_other_actors_done();
+  MESSAGE("checking that record batches span multiple messages");
+  auto stream = load_contents(dir / "bro::ssl.arrow");
+  REQUIRE(stream);
+  auto lengths = record_batch_lengths(*stream);
+  // A periodic flush may cut a record batch short, but the events arrive
+  // much faster than the flush interval.
+  CHECK(lengths.size() >= 3);
+  CHECK(lengths.size() < events.size());
+  for (auto n : lengths)
+    CHECK(n > 0 && n <= 50);
+  CHECK(std::accumulate(lengths.begin(), lengths.end(), int64_t{0}) == 113);
+  rm(dir);
+}
+
+TEST(ascii_sink) {
+  auto events = read_bro_log(m57_day11_18::ssl);
+  REQUIRE(events.size() == 113);
+  std::string expected;
+  auto i = std::back_inserter(expected);
+  for (auto& e : events)
+    REQUIRE(print(i, e) && print(i, '\n'));
+  CHECK(run_sink<sink::ascii>(events) == expected);
+}
+
+TEST(json_sink) {
+  auto events = read_bro_log(m57_day11_18::ssl);
+  REQUIRE(events.size() == 113);
+  MESSAGE("comparing direct formatting with the JSON DOM");
+  std::string expected;
+  auto i = std::back_inserter(expected);
+  for (auto& e : events) {
+    auto j = to<json>(e);
+    REQUIRE(j);
+    REQUIRE(print(i, *j) && print(i, '\n'));
+  }
+  CHECK(run_sink<sink::json>(events) == expected);
+  MESSAGE("comparing containers and subnets with the JSON DOM");
+  auto t = type::record{
+    {"s", type::set{type::count{}}},
+    {"t", type::table{type::string{}, type::count{}}},
+    {"n", type::subnet{}},
+    {"e", type::vector{type::count{}}},
+    {"i", type::record{{"x", type::boolean{}}, {"y", type::real{}}}}};
+  REQUIRE(t.name("test"));
+  auto sn = to<subnet>("10.0.0.0/8");
+  REQUIRE(sn);
+  auto r = record{set{1u, 2u},
+                  table{{"a", 1u}, {"b", 2u}},
+                  *sn,
+                  vector{},
+                  record{true, 4.2}};
+  events = {event::make(std::move(r), t)};
+  events[0].id(42);
+  expected.clear();
+  auto j = to<json>(events[0]);
+  REQUIRE(j);
+  REQUIRE(print(i, *j) && print(i, '\n'));
+  CHECK(run_sink<sink::json>(events) == expected);
+}
+
+TEST(bro_sink) {
+  auto events = read_bro_log(m57_day11_18::ssl);
+  REQUIRE(events.size() == 113);
+  path dir = "vast-test-bro-sink";
+  auto snk = self->spawn<sink::bro, monitored>(dir);
+  auto half = events.begin() + events.size() / 2;
+  self->send(snk, uuid::random(), std::vector<event>(events.begin(), half));
+  self->send(snk, uuid::random(), std::vector<event>(half, events.end()));
+  self->send_exit(snk, exit::done);
+  self->receive([&](down_msg const& d) { CHECK(d.reason == exit::done); });
+  self->await_all_other_actors_done();
+  MESSAGE("reading the written log back");
+  auto read = read_bro_log(dir / "bro::ssl.log");
+  REQUIRE(read.size() == events.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    CHECK(read[i].type() == events[i].type());
+    CHECK(read[i].timestamp() == events[i].timestamp());
+    CHECK(read[i].data() == events[i].data());
+  }
+  rm(dir);
+}
+
+FIXTURE_SCOPE_END()
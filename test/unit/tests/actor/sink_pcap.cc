@@ -0,0 +1,88 @@
+#include <algorithm>
+
+#include "vast/filesystem.h"
+#include "vast/actor/sink/pcap.h"
+#include "vast/actor/source/pcap.h"
+
+#define SUITE actors
+#include "test.h"
+#include "data.h"
+
+using namespace caf;
+using namespace vast;
+
+namespace {
+
+std::vector<event> read_trace(std::string const& trace) {
+  scoped_actor self;
+  auto src = self->spawn<source::pcap, monitored>(trace);
+  anon_send(src, put_atom::value, sink_atom::value, self);
+  self->receive([&](upstream_atom, actor const& a) { CHECK(a == src); });
+  anon_send(src, run_atom::value);
+  std::vector<event> result;
+  auto done = false;
+  self->do_receive(
+    [&](std::vector<event> const& events) {
+      result.insert(result.end(), events.begin(), events.end());
+    },
+    [&](down_msg const& d) {
+      CHECK(d.reason == exit::done);
+      done = true;
+    }
+  ).until([&] { return done; });
+  self->await_all_other_actors_done();
+  return result;
+}
+
+} // namespace <anonymous>
+
+TEST(pcap_sink) {
+  path trace = "vast-test-sink.pcap";
+  auto packets = read_trace(traces::nmap_vsn);
+  REQUIRE(packets.size() == 44);
+  MESSAGE("writing packets in reverse order across two batches");
+  std::vector<event> first(packets.rbegin(), packets.rbegin() + 20);
+  std::vector<event> second(packets.rbegin() + 20, packets.rend());
+  scoped_actor self;
+  auto snk = self->spawn<sink::pcap, monitored>(schema{}, trace, 10, 50);
+  self->send(snk, uuid::random(), first);
+  self->send(snk, uuid::random(), second);
+  self->send_exit(snk, exit::done);
+  self->receive([&](down_msg const& d) { CHECK(d.reason == exit::done); });
+  MESSAGE("reading packets back in timestamp order");
+  char buf[PCAP_ERRBUF_SIZE];
+#ifdef PCAP_TSTAMP_PRECISION_NANO
+  auto pcap = ::pcap_open_offline_with_tstamp_precision(
+    trace.str().c_str(), PCAP_TSTAMP_PRECISION_NANO, buf);
+  auto ns_per_tick = 1;
+#else
+  auto pcap = ::pcap_open_offline(trace.str().c_str(), buf);
+  auto ns_per_tick = 1000;
+#endif
+  REQUIRE(pcap != nullptr);
+  CHECK(::pcap_datalink(pcap) == DLT_RAW);
+  using packet = std::pair<int64_t, std::string>;
+  std::vector<packet> written;
+  pcap_pkthdr* header;
+  uint8_t const* data;
+  while (::pcap_next_ex(pcap, &header, &data) == 1) {
+    auto ns = header->ts.tv_sec * int64_t{1000000000}
+              + header->ts.tv_usec * ns_per_tick;
+    written.emplace_back(ns, std::string(reinterpret_cast<char const*>(data),
+                                         header->caplen));
+  }
+  ::pcap_close(pcap);
+  REQUIRE(written.size() == packets.size());
+  auto by_time = [](auto& x, auto& y) { return x.first < y.first; };
+  CHECK(std::is_sorted(written.begin(), written.end(), by_time));
+  std::vector<packet> expected;
+  for (auto& e : packets) {
+    auto ns = e.timestamp().time_since_epoch().count();
+    expected.emplace_back(ns / ns_per_tick * ns_per_tick,
+                          *get<std::string>(get<record>(e)->back()));
+  }
+  std::sort(expected.begin(), expected.end());
+  std::sort(written.begin(), written.end());
+  CHECK(written == expected);
+  rm(trace);
+}
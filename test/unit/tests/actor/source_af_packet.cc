@@ -0,0 +1,58 @@
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "vast/actor/source/af_packet.h"
+
+#define SUITE actors
+#include "test.h"
+
+using namespace caf;
+using namespace vast;
+
+TEST(af_packet_source) {
+  if (::geteuid() != 0) {
+    MESSAGE("skipping test that requires root privileges");
+    return;
+  }
+  scoped_actor self;
+  MESSAGE("spawning AF_PACKET source on loopback interface");
+  auto src = self->spawn<source::af_packet, monitored>(
+    "lo", -1, 100, 60, 10, 0, 1 << 16, 4);
+  anon_send(src, batch_atom::value, uint64_t{1});
+  anon_send(src, put_atom::value, sink_atom::value, self);
+  self->receive([&](upstream_atom, actor const& a) { CHECK(a == src); });
+  anon_send(src, run_atom::value);
+  MESSAGE("sending UDP datagrams to 127.0.0.1");
+  auto fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  REQUIRE(fd != -1);
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(4242);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto received = false;
+  for (auto i = 0; i < 50 && !received; ++i) {
+    auto n = ::sendto(fd, "vast", 4, 0, reinterpret_cast<sockaddr*>(&addr),
+                      sizeof(addr));
+    CHECK(n == 4);
+    self->receive(
+      [&](std::vector<event> const& events) {
+        REQUIRE(!events.empty());
+        CHECK(events[0].type().name() == "pcap::packet");
+        received = true;
+      },
+      after(std::chrono::milliseconds(100)) >> [] { }
+    );
+  }
+  ::close(fd);
+  CHECK(received);
+  self->send_exit(src, exit::done);
+  self->receive(
+    [&](down_msg const& d) { CHECK(d.reason == exit::done); }
+  );
+  self->await_all_other_actors_done();
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <fstream>
+
+#include "vast/config.h"
+#include "vast/filesystem.h"
+#include "vast/actor/source/bro.h"
+#include "vast/io/array_stream.h"
+#include "vast/io/decompressing_stream.h"
+#include "vast/io/file_stream.h"
+
+#define SUITE actors
+#include "test.h"
+#include "data.h"
+#include "fixtures/sources.h"
+
+using namespace caf;
+using namespace vast;
+
+namespace {
+
+struct fixture : fixtures::sources {
+  std::vector<event> run_bro_source(path const& file, uint64_t batch_size,
+                                    size_t parsers) {
+    auto is = std::make_unique<vast::io::file_input_stream>(file);
+    auto bro = self->spawn<source::bro>(std::move(is), parsers);
+    anon_send(bro, batch_atom::value, batch_size);
+    start(bro);
+    std::vector<event> result;
+    auto reason = drain([&](std::vector<event> const& events) {
+      CHECK(events.size() <= batch_size);
+      result.insert(result.end(), events.begin(), events.end());
+    });
+    CHECK(reason == exit::done);
+    return result;
+  }
+
+  // Grants a Bro source credit for only part of the log and checks that the
+  // source pauses until it gets more.
+  void check_credit(size_t parsers) {
+    auto is = std::make_unique<vast::io::file_input_stream>(m57_day11_18::ssl);
+    auto bro = self->spawn<source::bro>(std::move(is), parsers);
+    connect(bro);
+    MESSAGE("granting credit for 10 events");
+    self->send(bro, credit_atom::value, uint64_t{10}, uint64_t{1} << 30);
+    anon_send(bro, run_atom::value);
+    size_t events = 0;
+    uint64_t bytes = 0;
+    auto on_batch = [&](std::vector<event> const& batch, uint64_t n) {
+      events += batch.size();
+      bytes += n;
+    };
+    self->do_receive(on_batch).until([&] { return events >= 10; });
+    CHECK(events == 10);
+    CHECK(bytes > 0);
+    self->receive(
+      [&](std::vector<event> const&, uint64_t) {
+        FAIL("source exceeded its credit");
+      },
+      after(std::chrono::milliseconds(100)) >> [] { }
+    );
+    MESSAGE("granting credit for the remaining events");
+    self->send(bro, credit_atom::value, uint64_t{1000}, uint64_t{1} << 30);
+    CHECK(drain(on_batch) == exit::done);
+    CHECK(events == 113);
+  }
+};
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(source_bro_scope, fixture)
+
+TEST(bro_source_parallel) {
+  MESSAGE("parsing sequentially");
+  auto sequential = run_bro_source(m57_day11_18::ssl, 1000, 0);
+  REQUIRE(sequential.size() == 113);
+  CHECK(sequential[0].type().name() == "bro::ssl");
+  MESSAGE("parsing in parallel");
+  auto parallel = run_bro_source(m57_day11_18::ssl, 10, 3);
+  REQUIRE(parallel.size() == sequential.size());
+  for (size_t i = 0; i < parallel.size(); ++i) {
+    CHECK(parallel[i].type() == sequential[i].type());
+    CHECK(parallel[i].timestamp() == sequential[i].timestamp());
+    CHECK(get<record>(parallel[i]) != nullptr);
+    CHECK(*get<record>(parallel[i]) == *get<record>(sequential[i]));
+  }
+}
+
+TEST(bro_source_parallel_header_change) {
+  MESSAGE("concatenating two logs with different fields and separators");
+  auto ssl = load_contents(m57_day11_18::ssl);
+  auto smtp = load_contents(m57_day11_18::smtp);
+  REQUIRE(ssl && smtp);
+  std::replace(smtp->begin(), smtp->end(), '\t', '|');
+  auto sep = smtp->find("\\x09");
+  REQUIRE(sep != std::string::npos);
+  smtp->replace(sep, 4, "\\x7c");
+  path file = "vast-test-bro-concatenated.log";
+  {
+    std::ofstream out{file.str()};
+    out << *ssl << *smtp;
+  }
+  auto sequential = run_bro_source(file, 1000, 0);
+  REQUIRE(sequential.size() == 113 + 21);
+  CHECK(sequential.front().type().name() == "bro::ssl");
+  CHECK(sequential.back().type().name() == "bro::smtp");
+  MESSAGE("parsing in parallel with the header change inside a block");
+  auto parallel = run_bro_source(file, 7, 3);
+  REQUIRE(parallel.size() == sequential.size());
+  for (size_t i = 0; i < parallel.size(); ++i) {
+    CHECK(parallel[i].type() == sequential[i].type());
+    CHECK(parallel[i].timestamp() == sequential[i].timestamp());
+    CHECK(*get<record>(parallel[i]) == *get<record>(sequential[i]));
+  }
+  rm(file);
+}
+
+TEST(bro_source_batch_bytes) {
+  auto is = std::make_unique<vast::io::file_input_stream>(m57_day11_18::ssl);
+  auto bro = self->spawn<source::bro>(std::move(is));
+  MESSAGE("limiting batches to 4 KB of input");
+  anon_send(bro, batch_atom::value, uint64_t{1000}, uint64_t{4096},
+            time::duration{});
+  start(bro);
+  size_t events = 0;
+  size_t batches = 0;
+  auto reason = drain([&](std::vector<event> const& batch) {
+    CHECK(batch.size() < 100);
+    events += batch.size();
+    ++batches;
+  });
+  CHECK(reason == exit::done);
+  CHECK(events == 113);
+  CHECK(batches > 1);
+}
+
+TEST(bro_source_credit) {
+  check_credit(0);
+}
+
+TEST(bro_source_parallel_credit) {
+  // Blocks in flight at the workers must not exceed the credit either.
+  check_credit(3);
+}
+
+#ifdef VAST_HAVE_ZLIB
+TEST(bro_source_truncated_input) {
+  auto gz = load_contents(std::string{m57_day11_18::ssl} + ".gz");
+  REQUIRE(gz);
+  auto truncated = gz->substr(0, gz->size() / 2);
+  auto raw = std::make_unique<vast::io::array_input_stream>(
+    truncated.data(), truncated.size());
+  auto is = vast::io::make_decompressing_input_stream(std::move(raw));
+  REQUIRE(is);
+  auto bro = self->spawn<source::bro>(std::move(*is));
+  start(bro);
+  MESSAGE("expecting the source to fail after the readable events");
+  size_t events = 0;
+  auto reason = drain([&](std::vector<event> const& batch) {
+    events += batch.size();
+  });
+  CHECK(reason == exit::error);
+  CHECK(events > 0);
+  CHECK(events < 113);
+}
+#endif
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,81 @@
+#include <fstream>
+#include <map>
+
+#include "vast/filesystem.h"
+#include "vast/actor/source/bro.h"
+#include "vast/actor/source/multiplexer.h"
+#include "vast/actor/source/spawn.h"
+#include "vast/io/file_stream.h"
+
+#define SUITE actors
+#include "test.h"
+#include "data.h"
+#include "fixtures/sources.h"
+
+using namespace caf;
+using namespace vast;
+
+namespace {
+
+struct fixture : fixtures::sources {
+  std::map<std::string, size_t> run_source(actor const& src) {
+    anon_send(src, batch_atom::value, uint64_t{10});
+    start(src);
+    std::map<std::string, size_t> result;
+    auto reason = drain([&](std::vector<event> const& events) {
+      CHECK(events.size() <= 10);
+      for (auto& e : events)
+        ++result[e.type().name()];
+    });
+    CHECK(reason == exit::done);
+    return result;
+  }
+};
+
+actor make_bro_source(path const& file) {
+  auto is = std::make_unique<vast::io::file_input_stream>(file);
+  return spawn<source::bro>(std::move(is));
+}
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(source_multiplexer_scope, fixture)
+
+TEST(multiplexer_source) {
+  std::vector<std::string> files = {m57_day11_18::ssl, m57_day11_18::ftp,
+                                    m57_day11_18::dns};
+  MESSAGE("reading files one by one");
+  std::map<std::string, size_t> expected;
+  for (auto& file : files)
+    for (auto& p : run_source(make_bro_source(file)))
+      expected[p.first] += p.second;
+  REQUIRE(expected.size() == 3);
+  CHECK(expected["bro::ssl"] == 113);
+  MESSAGE("reading files concurrently");
+  auto factory = [](std::string const& file) -> trial<actor> {
+    return make_bro_source(file);
+  };
+  auto mux = spawn<source::multiplexer>(files, factory, 2);
+  CHECK(run_source(mux) == expected);
+}
+
+TEST(multiplexer_source_wildcard_file_name) {
+  MESSAGE("reading a directory with a file name containing wildcards");
+  path dir = "vast-test-multiplexer";
+  if (exists(dir))
+    REQUIRE(rm(dir));
+  REQUIRE(mkdir(dir));
+  auto ssl = load_contents(m57_day11_18::ssl);
+  auto ftp = load_contents(m57_day11_18::ftp);
+  REQUIRE(ssl && ftp);
+  std::ofstream{(dir / "ssl[1].log").str()} << *ssl;
+  std::ofstream{(dir / "ftp.log").str()} << *ftp;
+  auto src = source::spawn(make_message("bro", "-r", dir.str()));
+  REQUIRE(src);
+  auto result = run_source(*src);
+  CHECK(result["bro::ssl"] == 113);
+  CHECK(result["bro::ftp"] > 0);
+  rm(dir);
+}
+
+FIXTURE_SCOPE_END()
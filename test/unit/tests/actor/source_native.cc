@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <fstream>
+
+#include "vast/filesystem.h"
+#include "vast/actor/sink/native.h"
+#include "vast/actor/source/native.h"
+#include "vast/detail/native_format.h"
+#include "vast/io/file_stream.h"
+
+#define SUITE actors
+#include "test.h"
+#include "data.h"
+#include "fixtures/sources.h"
+
+using namespace caf;
+using namespace vast;
+
+namespace {
+
+// Counts the chunk frames in a native file.
+size_t count_chunks(std::string const& file) {
+  using namespace detail::native_format;
+  size_t result = 0;
+  auto pos = header_size;
+  while (pos + frame_header_size <= file.size()) {
+    auto frame = reinterpret_cast<uint8_t const*>(file.data() + pos);
+    if (frame[0] == chunk_frame)
+      ++result;
+    pos += frame_header_size + decode(frame + 1);
+  }
+  return result;
+}
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(source_native_scope, fixtures::sources)
+
+TEST(native_source) {
+  path file = "vast-test-native";
+  auto events = read_bro_log(m57_day11_18::ssl);
+  REQUIRE(events.size() == 113);
+  for (auto i = 0u; i < events.size(); ++i)
+    events[i].id(1000 + i);
+  MESSAGE("writing one event per message into chunks of 50 events");
+  auto snk = self->spawn<sink::native, monitored>(
+    std::make_unique<std::ofstream>(file.str()), io::lz4, size_t{50});
+  // The second half arrives out of ID order.
+  auto half = events.size() / 2;
+  for (size_t i = 0; i < half; ++i)
+    self->send(snk, uuid::random(), std::vector<event>{events[i]});
+  for (auto i = events.size(); i > half; --i)
+    self->send(snk, uuid::random(), std::vector<event>{events[i - 1]});
+  self->send_exit(snk, exit::done);
+  self->receive([&](down_msg const& d) { CHECK(d.reason == exit::done); });
+  auto contents = load_contents(file);
+  REQUIRE(contents);
+  // A periodic flush may cut a chunk short, but the events arrive much
+  // faster than the flush interval.
+  auto chunks = count_chunks(*contents);
+  CHECK(chunks >= 3);
+  CHECK(chunks < events.size());
+  MESSAGE("reading events back");
+  auto native = self->spawn<source::native, monitored>(
+    std::make_unique<io::file_input_stream>(file));
+  self->sync_send(native, get_atom::value, schema_atom::value).await(
+    [&](schema const& sch) {
+      REQUIRE(sch.size() == 1);
+      CHECK(*sch.begin() == events[0].type());
+    }
+  );
+  self->send_exit(native, exit::done);
+  self->receive([&](down_msg const&) {});
+  auto read = collect(self->spawn<source::native>(
+    std::make_unique<io::file_input_stream>(file)));
+  REQUIRE(read.size() == events.size());
+  // Each chunk has increasing IDs, but the chunks overlap.
+  std::sort(read.begin(), read.end(),
+            [](auto& x, auto& y) { return x.id() < y.id(); });
+  for (size_t i = 0; i < read.size(); ++i) {
+    CHECK(read[i].id() == events[i].id());
+    CHECK(read[i].type() == events[i].type());
+    CHECK(read[i].timestamp() == events[i].timestamp());
+    CHECK(read[i].data() == events[i].data());
+  }
+  rm(file);
+}
+
+TEST(native_source_truncated) {
+  path file = "vast-test-native-truncated";
+  auto events = read_bro_log(m57_day11_18::ssl);
+  REQUIRE(events.size() == 113);
+  for (auto i = 0u; i < events.size(); ++i)
+    events[i].id(i);
+  auto snk = self->spawn<sink::native, monitored>(
+    std::make_unique<std::ofstream>(file.str()), io::lz4, size_t{50});
+  self->send(snk, uuid::random(), events);
+  self->send_exit(snk, exit::done);
+  self->receive([&](down_msg const& d) { CHECK(d.reason == exit::done); });
+  auto contents = load_contents(file);
+  REQUIRE(contents);
+  MESSAGE("cutting the last chunk short");
+  {
+    std::ofstream out{file.str()};
+    out.write(contents->data(), contents->size() - 100);
+  }
+  auto native = self->spawn<source::native>(
+    std::make_unique<io::file_input_stream>(file));
+  start(native);
+  size_t n = 0;
+  auto reason = drain([&](std::vector<event> const& xs) { n += xs.size(); });
+  CHECK(reason == exit::error);
+  CHECK(n < events.size());
+  rm(file);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,88 @@
+#include <cstring>
+
+#include "vast/event.h"
+#include "vast/detail/arrow_writer.h"
+
+#define SUITE util
+#include "test.h"
+
+using namespace vast;
+
+namespace {
+
+template <typename T>
+T read(std::string const& buf, size_t pos) {
+  T x;
+  std::memcpy(&x, buf.data() + pos, sizeof(T));
+  return x;
+}
+
+// Locates a field of a FlatBuffers table, or returns 0 if absent.
+size_t field(std::string const& buf, size_t table, size_t id) {
+  auto vtable = table - read<int32_t>(buf, table);
+  if (4 + 2 * id >= read<uint16_t>(buf, vtable))
+    return 0;
+  auto offset = read<uint16_t>(buf, vtable + 4 + 2 * id);
+  return offset == 0 ? 0 : table + offset;
+}
+
+size_t follow(std::string const& buf, size_t pos) {
+  return pos + read<uint32_t>(buf, pos);
+}
+
+} // namespace <anonymous>
+
+TEST(arrow_writer) {
+  auto t = type::record{{"x", type::count{}}, {"y", type::string{}}};
+  REQUIRE(t.name("foo"));
+  detail::arrow_writer writer{t};
+  std::string stream;
+  writer.write_schema(stream);
+  for (auto i = 0u; i < 3; ++i) {
+    auto e = event::make(record{i, std::to_string(i)}, t);
+    REQUIRE(e.type() == t);
+    writer.add(e);
+  }
+  CHECK(writer.rows() == 3);
+  writer.write_batch(stream);
+  CHECK(writer.rows() == 0);
+  detail::arrow_writer::write_eos(stream);
+  MESSAGE("walking the encapsulated messages");
+  std::vector<uint8_t> headers;
+  size_t pos = 0;
+  while (pos < stream.size()) {
+    REQUIRE(read<uint32_t>(stream, pos) == 0xffffffff);
+    auto size = read<int32_t>(stream, pos + 4);
+    pos += 8;
+    if (size == 0)
+      break;
+    CHECK(size % 8 == 0);
+    auto metadata = stream.substr(pos, size);
+    pos += size;
+    auto message = follow(metadata, 0);
+    auto version = field(metadata, message, 0);
+    REQUIRE(version != 0);
+    CHECK(read<int16_t>(metadata, version) == 4);
+    auto header_type = field(metadata, message, 1);
+    REQUIRE(header_type != 0);
+    headers.push_back(read<uint8_t>(metadata, header_type));
+    auto header = follow(metadata, field(metadata, message, 2));
+    if (headers.back() == 3) {
+      // The record batch has 3 rows.
+      auto length = field(metadata, header, 0);
+      REQUIRE(length != 0);
+      CHECK(read<int64_t>(metadata, length) == 3);
+    } else {
+      // The schema has event ID, timestamp, x, and y.
+      auto fields = follow(metadata, field(metadata, header, 1));
+      CHECK(read<uint32_t>(metadata, fields) == 4);
+    }
+    auto body = field(metadata, message, 3);
+    REQUIRE(body != 0);
+    auto body_size = read<int64_t>(metadata, body);
+    CHECK(body_size % 8 == 0);
+    pos += body_size;
+  }
+  CHECK(pos == stream.size());
+  CHECK(headers == std::vector<uint8_t>({1, 3}));
+}
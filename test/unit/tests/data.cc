@@ -356,6 +356,15 @@ TEST(construction) {
   CHECK(is<record>(data{record{}}));
 }
 
+TEST(footprint) {
+  CHECK(footprint(data{42}) == sizeof(data));
+  CHECK(footprint(data{"foo"}) == sizeof(data) + 3);
+  auto v = vector{42, "foo"};
+  CHECK(footprint(data{v}) == 3 * sizeof(data) + 3);
+  auto r = record{"bar", v};
+  CHECK(footprint(data{r}) == 5 * sizeof(data) + 6);
+}
+
 TEST(relational_operators) {
   data d1;
   data d2;
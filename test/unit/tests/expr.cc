@@ -272,8 +272,34 @@ TEST(AST normalization) {
 
   VAST_INFO("performing all normalizations in one shot");
   expr = detail::to_expression("42 < a && ! (\"foo\" in bar || !! x == 1337)");
-  normalized = detail::to_expression("a > 42 && bar !ni \"foo\" && x != 1337");
+  normalized = detail::to_expression("x != 1337 && a > 42 && bar !ni \"foo\"");
   REQUIRE(expr);
   REQUIRE(normalized);
   CHECK(expr::normalize(*expr) == *normalized);
+
+  VAST_INFO("collapsing duplicates and range bounds");
+  expr = detail::to_expression("x > 5 && x == 1 && x >= 7 && x < 10 && x == 1");
+  normalized = detail::to_expression("x == 1 && x >= 7 && x < 10");
+  REQUIRE(expr);
+  REQUIRE(normalized);
+  CHECK(expr::normalize(*expr) == *normalized);
+  expr = detail::to_expression("x > 5 && x >= 5 && x <= 9 && x < 9");
+  normalized = detail::to_expression("x > 5 && x < 9");
+  REQUIRE(expr);
+  REQUIRE(normalized);
+  CHECK(expr::normalize(*expr) == *normalized);
+  expr = detail::to_expression("x == 1 || y == 2 || x == 1");
+  normalized = detail::to_expression("x == 1 || y == 2");
+  REQUIRE(expr);
+  REQUIRE(normalized);
+  CHECK(expr::normalize(*expr) == *normalized);
+
+  VAST_INFO("ordering operands by cost");
+  expr = detail::to_expression("s ~ /foo/ && s ni \"bar\" && &type == \"x\"");
+  normalized =
+    detail::to_expression("&type == \"x\" && s ni \"bar\" && s ~ /foo/");
+  REQUIRE(expr);
+  REQUIRE(normalized);
+  CHECK(expr::normalize(*expr) == *normalized);
+  CHECK(expr::cost(*normalized) == 1 + 8 + 16);
 }
@@ -166,3 +166,23 @@ TEST(file_and_directory_manipulation) {
   CHECK(rm(p.parent()));
   CHECK(!p.parent().is_directory());
 }
+
+TEST(disk_usage) {
+  path p = "/tmp/vast-unit-test-disk-usage";
+  p /= std::to_string(util::process_id());
+  REQUIRE(mkdir(p / "sub"));
+  CHECK(disk_usage(p) == 0);
+  std::string str(42, 'x');
+  {
+    file f{p / "foo"};
+    REQUIRE(f.open(file::write_only));
+    REQUIRE(f.write(str.data(), str.size()));
+    file g{p / "sub" / "bar"};
+    REQUIRE(g.open(file::write_only));
+    REQUIRE(g.write(str.data(), str.size()));
+  }
+  CHECK(disk_usage(p / "foo") == 42);
+  CHECK(disk_usage(p) == 84);
+  prefetch(p); // Only a hint, but must not fail.
+  CHECK(rm(p.parent()));
+}
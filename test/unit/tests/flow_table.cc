@@ -0,0 +1,82 @@
+#include "vast/actor/source/flow_table.h"
+
+#define SUITE util
+#include "test.h"
+
+using namespace vast;
+using namespace vast::source;
+
+namespace {
+
+detail::connection make_connection(uint16_t sport) {
+  detail::connection conn;
+  uint32_t src = 0x0a000001;
+  uint32_t dst = 0x0a000002;
+  conn.src = {&src, address::ipv4, address::host};
+  conn.dst = {&dst, address::ipv4, address::host};
+  conn.sport = {sport, port::tcp};
+  conn.dport = {80, port::tcp};
+  return conn;
+}
+
+} // namespace <anonymous>
+
+TEST(flow_table_access) {
+  flow_table flows{100, 60};
+  auto& f = flows.access(make_connection(1), 1000);
+  CHECK(f.bytes == 0);
+  CHECK(f.last == 1000);
+  f.bytes += 42;
+  CHECK(flows.access(make_connection(1), 1001).bytes == 42);
+  CHECK(flows.size() == 1);
+  for (uint16_t i = 2; i <= 100; ++i)
+    flows.access(make_connection(i), 1001);
+  CHECK(flows.size() == 100);
+  for (uint16_t i = 1; i <= 100; ++i) {
+    auto f = flows.find(make_connection(i));
+    REQUIRE(f != nullptr);
+    CHECK(f->conn == make_connection(i));
+  }
+  CHECK(flows.find(make_connection(101)) == nullptr);
+}
+
+TEST(flow_table_expiration) {
+  flow_table flows{100, 10, 2};
+  for (uint16_t i = 0; i < 10; ++i)
+    flows.access(make_connection(i), 1000);
+  for (uint16_t i = 10; i < 20; ++i)
+    flows.access(make_connection(i), 1005);
+  MESSAGE("keeping flows that are not yet due");
+  flows.expire(1010);
+  CHECK(flows.size() == 20);
+  MESSAGE("evicting flows inactive for more than 10 seconds");
+  flows.expire(1012);
+  CHECK(flows.size() == 10);
+  CHECK(flows.find(make_connection(0)) == nullptr);
+  CHECK(flows.find(make_connection(10)) != nullptr);
+  MESSAGE("rescheduling flows on access");
+  flows.access(make_connection(10), 1012);
+  flows.expire(1020);
+  CHECK(flows.size() == 1);
+  CHECK(flows.find(make_connection(10)) != nullptr);
+  MESSAGE("evicting all flows after a long gap");
+  flows.expire(100000);
+  CHECK(flows.size() == 0);
+}
+
+TEST(flow_table_eviction) {
+  flow_table flows{4, 60};
+  for (uint16_t i = 0; i < 4; ++i)
+    flows.access(make_connection(i), 1000);
+  // A second packet marks flows 0 and 1 as recently used.
+  flows.access(make_connection(0), 1001);
+  flows.access(make_connection(1), 1001);
+  MESSAGE("evicting the first flow without a recent packet");
+  flows.access(make_connection(4), 1002);
+  CHECK(flows.size() == 4);
+  CHECK(flows.find(make_connection(0)) != nullptr);
+  CHECK(flows.find(make_connection(1)) != nullptr);
+  CHECK(flows.find(make_connection(2)) == nullptr);
+  CHECK(flows.find(make_connection(3)) != nullptr);
+  CHECK(flows.find(make_connection(4)) != nullptr);
+}
@@ -1,13 +1,23 @@
+#include "vast/config.h"
+#include "vast/filesystem.h"
 #include "vast/io/algorithm.h"
+#include "vast/io/array_stream.h"
 #include "vast/io/buffered_stream.h"
+#include "vast/io/decompressing_stream.h"
+#include "vast/io/file_stream.h"
 #include "vast/io/iterator.h"
 #include "vast/io/formatted.h"
 #include "vast/io/container_stream.h"
 #include "vast/io/range.h"
 #include "vast/io/stream_device.h"
 
+#ifdef VAST_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #define SUITE IO
 #include "test.h"
+#include "data.h"
 
 using namespace vast;
 
@@ -167,3 +177,92 @@ TEST(formatted input) {
   in >> str;
   CHECK(str == "bar");
 }
+
+TEST(decompressing_input_stream) {
+  auto plain = load_contents(m57_day11_18::ssl);
+  REQUIRE(plain);
+  MESSAGE("uncompressed input passes through");
+  auto raw = std::make_unique<io::file_input_stream>(m57_day11_18::ssl);
+  auto is = io::make_decompressing_input_stream(std::move(raw));
+  REQUIRE(is);
+  CHECK(dynamic_cast<io::file_input_stream*>(is->get()) != nullptr);
+#ifdef VAST_HAVE_ZLIB
+  MESSAGE("gzip input gets decompressed");
+  auto gz = std::string{m57_day11_18::ssl} + ".gz";
+  raw = std::make_unique<io::file_input_stream>(gz);
+  auto gz_is = io::make_decompressing_input_stream(std::move(raw), 1000);
+  REQUIRE(gz_is);
+  std::string str;
+  void const* buf;
+  size_t size;
+  while ((*gz_is)->next(&buf, &size)) {
+    CHECK(size <= 1000);
+    str.append(reinterpret_cast<char const*>(buf), size);
+  }
+  CHECK(str == *plain);
+  CHECK((*gz_is)->bytes() == plain->size());
+  CHECK((*gz_is)->status());
+#endif
+}
+
+TEST(decompressing_input_stream failure) {
+#ifdef VAST_HAVE_ZLIB
+  auto gz = load_contents(std::string{m57_day11_18::ssl} + ".gz");
+  REQUIRE(gz);
+  auto decode = [](std::string const& input) {
+    auto raw = std::make_unique<io::array_input_stream>(input.data(),
+                                                        input.size());
+    auto is = io::make_decompressing_input_stream(std::move(raw), 1000);
+    REQUIRE(is);
+    void const* buf;
+    size_t size;
+    while ((*is)->next(&buf, &size))
+      ; // Drain the stream.
+    return (*is)->status();
+  };
+  MESSAGE("truncated gzip input");
+  auto truncated = decode(gz->substr(0, gz->size() / 2));
+  REQUIRE(!truncated);
+  CHECK(truncated.error().msg() == "truncated gzip input");
+  MESSAGE("corrupt gzip input");
+  auto corrupt = *gz;
+  corrupt[corrupt.size() / 2] ^= 0x55;
+  corrupt[corrupt.size() / 2 + 1] ^= 0x55;
+  CHECK(!decode(corrupt));
+#endif
+}
+
+#ifdef VAST_HAVE_ZSTD
+TEST(decompressing_input_stream zstd) {
+  auto plain = load_contents(m57_day11_18::ssl);
+  REQUIRE(plain);
+  std::string zst(ZSTD_compressBound(plain->size()), '\0');
+  auto n = ZSTD_compress(&zst[0], zst.size(), plain->data(), plain->size(), 3);
+  REQUIRE(!ZSTD_isError(n));
+  zst.resize(n);
+  MESSAGE("concatenated frames decode as one stream");
+  auto input = zst + zst;
+  auto raw = std::make_unique<io::array_input_stream>(input.data(),
+                                                      input.size());
+  auto is = io::make_decompressing_input_stream(std::move(raw), 1000);
+  REQUIRE(is);
+  std::string str;
+  void const* buf;
+  size_t size;
+  while ((*is)->next(&buf, &size)) {
+    CHECK(size <= 1000);
+    str.append(reinterpret_cast<char const*>(buf), size);
+  }
+  CHECK(str == *plain + *plain);
+  CHECK((*is)->status());
+  MESSAGE("truncated zstd input");
+  raw = std::make_unique<io::array_input_stream>(zst.data(), zst.size() - 2);
+  is = io::make_decompressing_input_stream(std::move(raw), 1000);
+  REQUIRE(is);
+  while ((*is)->next(&buf, &size))
+    ; // Drain the stream.
+  auto status = (*is)->status();
+  REQUIRE(!status);
+  CHECK(status.error().msg() == "truncated zstd input");
+}
+#endif
@@ -0,0 +1,35 @@
+#include "vast/io/array_stream.h"
+#include "vast/io/line_reader.h"
+
+#define SUITE IO
+#include "test.h"
+
+using namespace vast;
+
+TEST(line_reader) {
+  auto str = "\n1st\nline\rn3\r\nline4\nline5\n\nline6\nlast";
+  for (size_t i = 1; i < 12; ++i) {
+    io::array_input_stream input(str, std::strlen(str), i);
+    io::line_reader reader{input};
+    CHECK(reader.next());
+    CHECK(reader.line().empty());
+    CHECK(reader.next());
+    CHECK(reader.line() == "1st");
+    CHECK(reader.next());
+    CHECK(reader.line() == "line");
+    CHECK(reader.next());
+    CHECK(reader.line() == "n3");
+    CHECK(reader.next());
+    CHECK(reader.line() == "line4");
+    CHECK(reader.next());
+    CHECK(reader.line() == "line5");
+    CHECK(reader.next());
+    CHECK(reader.line().empty());
+    CHECK(reader.next());
+    CHECK(reader.line() == "line6");
+    // Unlike io::getline, the reader also yields a final unterminated line.
+    CHECK(reader.next());
+    CHECK(reader.line() == "last");
+    CHECK(!reader.next());
+  }
+}
@@ -1,6 +1,7 @@
 #include "vast/concept/parseable/to.h"
 #include "vast/concept/parseable/vast/address.h"
 #include "vast/concept/parseable/vast/subnet.h"
+#include "vast/concept/parseable/vast/detail/bro_fast_parsers.h"
 #include "vast/concept/parseable/vast/detail/bro_parser_factory.h"
 
 #define SUITE parseable
@@ -43,3 +44,40 @@ TEST(bro data) {
   CHECK(bro_parse(type::set{type::string{}}, "49329,42", d));
   CHECK(d == set{"49329", "42"});
 }
+
+TEST(bro fast parsers) {
+  MESSAGE("count");
+  auto u64 = detail::bro_unsigned_parser<count>{};
+  count c;
+  CHECK(u64("18446744073709551615"s, c));
+  CHECK(c == 18446744073709551615ull);
+  CHECK(!u64("x42"s, c));
+  CHECK(!u64(""s, c));
+  MESSAGE("real");
+  auto real = detail::bro_real_parser{};
+  for (auto str : {"1258594163.566694"s, "-0.5"s, "42."s, ".25"s,
+                   "1234567890123456.1"s}) {
+    double x;
+    double y;
+    CHECK(real(str, x));
+    CHECK(parsers::real(str, y));
+    CHECK(x == y);
+  }
+  double x;
+  CHECK(!real("42"s, x));
+  CHECK(!real("."s, x));
+  MESSAGE("address");
+  auto addr = detail::bro_address_parser{};
+  for (auto str : {"192.168.1.103"s, "255.255.255.255"s, "::"s, "::1"s,
+                   "fe80::1"s, "2001:db8:0:0:1:0:0:1"s, "1:2:3:4:5:6:7:8"s,
+                   "2001:DB8::8:800:200C:417A"s, "::ffff:10.0.0.1"s}) {
+    address a;
+    address b;
+    CHECK(addr(str, a));
+    CHECK(parsers::addr(str, b));
+    CHECK(a == b);
+  }
+  address a;
+  CHECK(!addr("256.1.1.1"s, a));
+  CHECK(!addr("foo"s, a));
+}
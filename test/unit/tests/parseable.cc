@@ -177,6 +177,71 @@ TEST(attribute compatibility : pair) {
   CHECK(p1.second == "y");
 }
 
+TEST(fused combinators) {
+  using namespace parsers;
+  MESSAGE("adjacent literals");
+  auto lits = alpha >> ':' >> ' ' >> "foo";
+  static_assert(
+    std::is_same<
+      decltype(lits),
+      sequence_parser<alpha_parser, ignore_parser<string_parser>>
+    >{},
+    "adjacent literals not fused");
+  auto str = "x: foo"s;
+  auto f = str.begin();
+  auto l = str.end();
+  char c;
+  CHECK(lits.parse(f, l, c));
+  CHECK(c == 'x');
+  CHECK(f == l);
+  str = "x: fox"s;
+  f = str.begin();
+  l = str.end();
+  CHECK(!lits.parse(f, l, c));
+  CHECK(f == str.begin());
+
+  MESSAGE("character runs");
+  auto field = +(any - ',');
+  str = "foo,bar"s;
+  f = str.begin();
+  l = str.end();
+  auto attr = ""s;
+  CHECK(field.parse(f, l, attr));
+  CHECK(attr == "foo");
+  CHECK(*f == ',');
+  f = str.begin();
+  CHECK((*alpha >> ',' >> +alpha).parse(f, l, unused));
+  CHECK(f == l);
+  f = str.begin();
+  CHECK(!(+digit).parse(f, l, unused));
+  CHECK(f == str.begin());
+  // Ignored characters do not end up in the attribute.
+  f = str.begin();
+  attr.clear();
+  CHECK((+ignore(any - ',')).parse(f, l, attr));
+  CHECK(attr.empty());
+  CHECK(*f == ',');
+  CHECK((*ignore(chr{','})).parse(f, l, attr));
+  CHECK(attr.empty());
+
+  MESSAGE("ignored action result");
+  // Actions may have side effects, so they run even if the caller ignores
+  // their result.
+  auto calls = 0;
+  auto p = +digit ->* [&](std::string x) { ++calls; return x.size(); };
+  str = "1234"s;
+  f = str.begin();
+  l = str.end();
+  CHECK(p.parse(f, l, unused));
+  CHECK(f == l);
+  CHECK(calls == 1);
+  size_t n;
+  f = str.begin();
+  CHECK(p.parse(f, l, n));
+  CHECK(n == 4);
+  CHECK(calls == 2);
+}
+
 TEST(bool) {
   auto p0 = single_char_bool_parser{};
   auto p1 = zero_one_bool_parser{};
@@ -0,0 +1,138 @@
+#include "vast/detail/query_scheduler.h"
+#include "vast/concept/parseable/vast/detail/to_expression.h"
+
+#define SUITE index
+#include "test.h"
+
+using namespace vast;
+using detail::query_scheduler;
+
+namespace {
+
+expression make_expr(std::string const& str) {
+  auto expr = detail::to_expression(str);
+  REQUIRE(expr);
+  return *expr;
+}
+
+} // namespace <anonymous>
+
+TEST(query scheduler round-robin) {
+  query_scheduler s{1};
+  auto x = make_expr(":addr == 10.0.0.1");
+  auto y = make_expr(":port == 53/udp");
+  auto p0 = uuid::random();
+  auto p1 = uuid::random();
+  auto p2 = uuid::random();
+  s.add(x, query_scheduler::high);
+  s.add(y, query_scheduler::high);
+  s.enqueue(x, p0);
+  s.enqueue(x, p1);
+  s.enqueue(y, p2);
+  CHECK(s.pending() == 3);
+  // Each query gets one partition at a time, alternating between queries.
+  auto n = s.next();
+  REQUIRE(n);
+  auto first = n->first;
+  CHECK(first == p0 || first == p2);
+  n = s.next();
+  REQUIRE(n);
+  CHECK(n->first != first);
+  CHECK(n->first == p0 || n->first == p2);
+  // Both queries have reached their limit.
+  CHECK(!s.next());
+  CHECK(s.busy(p0));
+  CHECK(!s.busy(p1));
+  CHECK(s.complete(x, p0));
+  n = s.next();
+  REQUIRE(n);
+  CHECK(n->first == p1);
+  CHECK(s.pending() == 0);
+  CHECK(s.queries() == 2);
+  // Queries without any work left vanish.
+  CHECK(s.complete(y, p2));
+  CHECK(s.queries() == 1);
+  CHECK(s.complete(x, p1));
+  CHECK(s.queries() == 0);
+}
+
+TEST(query scheduler priorities) {
+  query_scheduler s;
+  auto x = make_expr(":addr == 10.0.0.1");
+  auto y = make_expr(":port == 53/udp");
+  auto p0 = uuid::random();
+  auto p1 = uuid::random();
+  s.add(x, query_scheduler::low);
+  s.add(y, query_scheduler::high);
+  s.enqueue(x, p0);
+  s.enqueue(y, p1);
+  CHECK(s.pending(query_scheduler::low) == 1);
+  CHECK(s.pending(query_scheduler::high) == 1);
+  auto n = s.next();
+  REQUIRE(n);
+  CHECK(n->first == p1);
+  n = s.next();
+  REQUIRE(n);
+  CHECK(n->first == p0);
+}
+
+TEST(query scheduler shared scans) {
+  query_scheduler s;
+  auto x = make_expr(":addr == 10.0.0.1");
+  auto y = make_expr(":port == 53/udp");
+  auto p = uuid::random();
+  s.add(x, query_scheduler::high);
+  s.add(y, query_scheduler::low);
+  s.enqueue(x, p);
+  s.enqueue(y, p);
+  auto n = s.next();
+  REQUIRE(n);
+  CHECK(n->first == p);
+  CHECK(n->second.size() == 2);
+  CHECK(s.pending() == 0);
+  CHECK(!s.complete(x, p));
+  CHECK(s.busy(p));
+  CHECK(s.complete(y, p));
+  CHECK(!s.busy(p));
+}
+
+TEST(query scheduler admission) {
+  query_scheduler s;
+  auto x = make_expr(":addr == 10.0.0.1");
+  auto p0 = uuid::random();
+  auto p1 = uuid::random();
+  auto p2 = uuid::random();
+  s.add(x, query_scheduler::high);
+  s.enqueue(x, p0);
+  s.enqueue(x, p1);
+  s.enqueue(x, p2);
+  auto upcoming = s.peek(2);
+  REQUIRE(upcoming.size() == 2);
+  CHECK(upcoming[0] == p0);
+  CHECK(upcoming[1] == p1);
+  // A rejected partition blocks the schedule without altering it.
+  CHECK(!s.next([](uuid const&) { return false; }));
+  CHECK(s.pending() == 3);
+  auto n = s.next([&](uuid const& part) { return part == p0; });
+  REQUIRE(n);
+  CHECK(n->first == p0);
+  CHECK(s.peek(5) == std::vector<uuid>{p1, p2});
+}
+
+TEST(query scheduler removal) {
+  query_scheduler s;
+  auto x = make_expr(":addr == 10.0.0.1");
+  auto y = make_expr(":port == 53/udp");
+  auto p0 = uuid::random();
+  auto p1 = uuid::random();
+  s.add(x, query_scheduler::high);
+  s.add(y, query_scheduler::high);
+  s.enqueue(x, p0);
+  s.enqueue(x, p1);
+  s.enqueue(y, p1);
+  // Only the partitions no other query waits for become orphans.
+  CHECK(s.remove(x) == std::vector<uuid>{p0});
+  CHECK(s.pending() == 1);
+  CHECK(s.remove(y) == std::vector<uuid>{p1});
+  CHECK(s.queries() == 0);
+}
@@ -126,3 +126,30 @@ TEST(string splitting and joining) {
   str = join(s, " ");
   CHECK(str == "a - b - c*-d");
 }
+
+TEST(string splitting of contiguous sequences) {
+  // Exceeds the 16-byte blocks of the vectorized scan and has separators
+  // straddling their boundaries.
+  auto str = std::string{"0123456789abcd\t\tefghijklmnopq*\t\trstu\t\tvw"};
+  std::vector<std::pair<char const*, char const*>> pos;
+  split(str.data(), str.data() + str.size(), "\t\t", pos, "*");
+  REQUIRE(pos.size() == 3);
+  CHECK(std::string(pos[0].first, pos[0].second) == "0123456789abcd");
+  CHECK(std::string(pos[1].first, pos[1].second) == "efghijklmnopq*\t\trstu");
+  CHECK(std::string(pos[2].first, pos[2].second) == "vw");
+  // The buffer accumulates results across invocations.
+  split(str.data(), str.data() + str.size(), "\t", pos, "", 1);
+  REQUIRE(pos.size() == 5);
+  CHECK(std::string(pos[3].first, pos[3].second) == "0123456789abcd");
+  CHECK(pos[4].first == str.data() + 15);
+  CHECK(pos[4].second == str.data() + str.size());
+  // Results match those of the generic version.
+  auto generic = split(str.begin(), str.end(), "\t", "*");
+  pos.clear();
+  split(str.data(), str.data() + str.size(), "\t", pos, "*");
+  REQUIRE(pos.size() == generic.size());
+  for (size_t i = 0; i < pos.size(); ++i) {
+    CHECK(pos[i].first - str.data() == generic[i].first - str.begin());
+    CHECK(pos[i].second - str.data() == generic[i].second - str.begin());
+  }
+}